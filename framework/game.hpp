@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <cstdint>
+
 
 namespace Game
 {
@@ -10,4 +12,29 @@ namespace Game
 
 	void mouseButtonPressed( float x, float y );
 	void mouseButtonReleased( float x, float y );
+
+	// physics steps per frame, clamped to [ 0.1, 16 ]; meshes are interpolated between steps
+	void setTimeScale( float scale );
+
+	// directory of the files the game keeps between runs, the pocketability cache; it ends
+	// in a path separator, empty is the working directory. Takes effect on the next init
+	void setDataDirectory( char const* path );
+
+	// racks balls of mixed radii and masses, see PhysicTable::Rack; takes effect on the next init
+	void setMixedRack( bool enabled );
+
+	// the bot takes every other shot, planned by game_cpp/planner.hpp
+	void setBotOpponent( bool enabled );
+
+	// chained hash of the physics state after the last step, see game_cpp/checksum.hpp
+	uint64_t stateChecksum();
+	// appends every step's checksum to the file, nullptr stops recording
+	void recordChecksums( char const* path );
+	// records a seekable replay, see game_cpp/replay.hpp, nullptr finishes the file
+	void recordReplay( char const* path );
+
+	// headless giant table run, see game_cpp/stress.hpp; prints the timing and the final
+	// checksum, which is the same for any thread count. 0 steps or threads and a negative
+	// reorder interval pick the defaults, a 0 interval never reorders
+	void runStress( int balls, int steps, int threads, int reorderInterval = -1 );
 }
@@ -0,0 +1,87 @@
+#include <cmath>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include "checksum.hpp"
+#include "hashing.hpp"
+
+
+namespace Checksum
+{
+	namespace
+	{
+		using Hashing::mix;
+
+		char const* const resetLine = "reset";
+
+
+		uint64_t quantise( float value, float quantum )
+		{
+			return uint64_t( int64_t( std::llround( double( value ) / double( quantum ) ) ) );
+		}
+	}
+
+
+	uint64_t ballHash( BillBall const &ball, int slot, bool inGame )
+	{
+		uint64_t hash = mix( uint64_t( slot ) + 1 );
+		if ( !inGame )
+			return mix( hash ^ 0xDEADull );
+
+		hash = mix( hash ^ quantise( ball.getPosition().x, positionQuantum ) );
+		hash = mix( hash ^ quantise( ball.getPosition().y, positionQuantum ) );
+		hash = mix( hash ^ quantise( ball.getSpeed().x, speedQuantum ) );
+		hash = mix( hash ^ quantise( ball.getSpeed().y, speedQuantum ) );
+		return hash;
+	}
+
+
+	Frame compute( PhysicTable const &table, uint32_t frame, uint64_t previous )
+	{
+		Frame result;
+		result.frame = frame;
+
+		uint64_t hash = mix( previous ^ uint64_t( table.inGameMask() ) );
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		{
+			result.balls[ i ] = ballHash( table.balls[ i ], i, table.inGame[ i ] );
+			hash = mix( hash ^ result.balls[ i ] );
+		}
+		result.table = hash;
+		return result;
+	}
+
+
+	void write( std::ostream &stream, Frame const &frame )
+	{
+		std::ostringstream line;
+		line << std::hex << frame.frame << ' ' << frame.table;
+		for ( uint64_t ball : frame.balls )
+			line << ' ' << ball;
+		stream << line.str() << '\n';
+	}
+
+
+	void writeReset( std::ostream &stream )
+	{
+		stream << resetLine << '\n';
+	}
+
+
+	Record read( std::istream &stream, Frame &frame )
+	{
+		std::string text;
+		if ( !std::getline( stream, text ) )
+			return Record::end;
+		if ( text == resetLine )
+			return Record::reset;
+
+		std::istringstream line( text );
+		line >> std::hex >> frame.frame >> frame.table;
+		for ( uint64_t &ball : frame.balls )
+			line >> ball;
+		return line.fail() ? Record::end : Record::frame;
+	}
+}
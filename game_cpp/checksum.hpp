@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iosfwd>
+
+#include "physics.hpp"
+
+
+//-------------------------------------------------------
+//	Physics state checksums for desync detection
+//
+//	Positions and speeds are quantised before hashing so the
+//	checksum only flags real divergence, not the last bit of
+//	a float printed differently. Every frame keeps one hash
+//	per ball slot, which tells where two runs split, and a
+//	table hash chained with the previous frame's, so equal
+//	table hashes mean equal histories up to that frame.
+//-------------------------------------------------------
+
+namespace Checksum
+{
+	constexpr float positionQuantum = 1e-4f;
+	constexpr float speedQuantum = 1e-5f;
+
+	struct Frame
+	{
+		uint32_t frame = 0;
+		uint64_t table = 0;
+		std::array< uint64_t, PhysicTable::numBalls > balls = {};
+	};
+
+	uint64_t ballHash( BillBall const &ball, int slot, bool inGame );
+
+	// previous is the table hash of the frame before, 0 for the first one
+	Frame compute( PhysicTable const &table, uint32_t frame, uint64_t previous );
+
+	// one line per frame: frame, table hash and ball hashes in hex
+	void write( std::ostream &stream, Frame const &frame );
+	// A restart numbers frames from 0 again with a new chain, the stream marks it with a
+	// reset line so frames of different rounds are never paired.
+	void writeReset( std::ostream &stream );
+
+	enum class Record { frame, reset, end };
+	Record read( std::istream &stream, Frame &frame );
+}
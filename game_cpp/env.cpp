@@ -0,0 +1,356 @@
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "env.hpp"
+#include "params.hpp"
+#include "physics.hpp"
+#include "random.hpp"
+#include "shots.hpp"
+#include "table_batch.hpp"
+#include "workers.hpp"
+
+
+static_assert( minibillEnvNumBalls == PhysicTable::numBalls, "observation layout is out of sync with the table" );
+
+
+struct MinibillEnv
+{
+	// storage is the batch state, in shared memory for a shared env
+	MinibillEnv( int numEnvs, float* storage );
+
+	TableBatch batch;
+	std::unique_ptr< Workers > workers = std::make_unique< Workers >( 1 );
+	std::vector< int > episodeShots;
+
+	// randomisation is keyed by ( env, episode ) and ( env, shot ), see Random::Stream
+	std::vector< uint32_t > episodes;
+	std::vector< uint32_t > shots;
+	uint32_t seed = 0;
+	float rackJitter = 0.f;
+	float directionNoise = 0.f;
+	float powerNoise = 0.f;
+
+	MinibillEnvSharedHeader* shared = nullptr;
+	std::vector< int > sharedDones;
+};
+
+
+MinibillEnv::MinibillEnv( int numEnvs, float* storage ) :
+	batch( numEnvs, storage ),
+	episodeShots( numEnvs, 0 ),
+	episodes( numEnvs, 0 ),
+	shots( numEnvs, 0 )
+{
+	PhysicTable table;
+	table.reset();
+	for ( int e = 0; e < numEnvs; e++ )
+		batch.load( e, table );
+}
+
+
+namespace
+{
+	void writeObservation( MinibillEnv const* env, int e, float* observation )
+	{
+		PhysicTable table;
+		env->batch.store( e, table );
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		{
+			observation[ 3 * i + 0 ] = table.balls[ i ].getPosition().x;
+			observation[ 3 * i + 1 ] = table.balls[ i ].getPosition().y;
+			observation[ 3 * i + 2 ] = table.inGame[ i ] ? 1.f : 0.f;
+		}
+	}
+
+
+	void startEpisode( MinibillEnv* env, int e )
+	{
+		PhysicTable table;
+		table.reset();
+		if ( env->rackJitter > 0.f )
+		{
+			Random::Stream stream( uint32_t( e ), env->episodes[ e ], Random::Purpose::rack, env->seed );
+			Shots::jitterRack( table, stream, env->rackJitter );
+		}
+		env->batch.load( e, table );
+		env->episodes[ e ]++;
+		env->episodeShots[ e ] = 0;
+	}
+
+
+	void strike( MinibillEnv* env, int e, float directionX, float directionY, float power )
+	{
+		Shot shot;
+		shot.direction = Vector2( directionX, directionY );
+		shot.power = power;
+		if ( env->directionNoise > 0.f || env->powerNoise > 0.f )
+		{
+			Random::Stream stream( uint32_t( e ), env->shots[ e ], Random::Purpose::noise, env->seed );
+			if ( shot.direction.x != 0.f || shot.direction.y != 0.f )
+				shot = Shots::noisyShot( shot, stream, env->directionNoise, env->powerNoise );
+		}
+		env->shots[ e ]++;
+		env->batch.strike( e, shot );
+	}
+
+
+	// The counters are formally std::atomic objects living in the region, created by
+	// minibillEnvCreateShared; lock free atomics are address free, so the other
+	// process sees the same words.
+	static_assert( sizeof( std::atomic< uint32_t > ) == sizeof( uint32_t ) && alignof( std::atomic< uint32_t > ) == alignof( uint32_t ), "shared counters must be plain 32 bit words" );
+	static_assert( std::atomic< uint32_t >::is_always_lock_free, "shared counters must be lock free to be address free" );
+
+	std::atomic< uint32_t > &sharedCounter( uint32_t &value )
+	{
+		return *std::launder( reinterpret_cast< std::atomic< uint32_t >* >( &value ) );
+	}
+
+
+	// spins briefly, then yields, then sleeps doubling up to a millisecond
+	uint32_t waitForRequest( std::atomic< uint32_t > const &actionSequence, uint32_t served )
+	{
+		constexpr int spins = 1000;
+		constexpr int yields = 100;
+		constexpr int maxSleepMicroseconds = 1000;
+
+		int sleepMicroseconds = 10;
+		for ( int attempt = 0; ; attempt++ )
+		{
+			uint32_t const requested = actionSequence.load( std::memory_order_acquire );
+			if ( requested != served )
+				return requested;
+
+			if ( attempt < spins )
+				continue;
+			if ( attempt < spins + yields )
+			{
+				std::this_thread::yield();
+				continue;
+			}
+			std::this_thread::sleep_for( std::chrono::microseconds( sleepMicroseconds ) );
+			sleepMicroseconds = std::min( 2 * sleepMicroseconds, maxSleepMicroseconds );
+		}
+	}
+
+
+	size_t alignedOffset( size_t offset )
+	{
+		constexpr size_t alignment = 64;
+		return ( offset + alignment - 1 ) / alignment * alignment;
+	}
+
+
+	// Steps every table until all of them rest, one vector lane per table. Each worker
+	// takes a range of blocks and runs it to rest on its own, no sync between steps.
+	void playShots( MinibillEnv* env, std::vector< int > &pocketedMasks )
+	{
+		TableBatch &batch = env->batch;
+		std::fill( batch.pocketedMasks.begin(), batch.pocketedMasks.end(), 0 );
+
+		env->workers->parallelFor( batch.blockCount(), [ &batch ]( int begin, int end )
+		{
+			for ( int stepIndex = 0; stepIndex < Params::Env::maxShotSteps && !batch.isResting( begin, end ); stepIndex++ )
+				batch.step( begin, end );
+		} );
+
+		for ( int e = 0; e < batch.size(); e++ )
+			pocketedMasks[ e ] = batch.pocketedMasks[ e ];
+	}
+
+
+	// plays the struck shots to rest and scores them, done environments are reset
+	void finishShots( MinibillEnv* env, float* rewards, int* dones )
+	{
+		int const numEnvs = env->batch.size();
+
+		std::vector< int > pocketedMasks( numEnvs );
+		playShots( env, pocketedMasks );
+
+		for ( int e = 0; e < numEnvs; e++ )
+		{
+			int const pocketed = pocketedMasks[ e ];
+			bool const scratch = Shots::isScratch( pocketed );
+			bool const cleared = ( env->batch.inGameMask( e ) & ~1 ) == 0;
+
+			env->episodeShots[ e ]++;
+			bool const done = scratch || cleared || env->episodeShots[ e ] >= Params::Env::maxEpisodeShots;
+
+			rewards[ e ] = Shots::reward( pocketed );
+			dones[ e ] = done ? 1 : 0;
+
+			if ( done )
+				startEpisode( env, e );
+		}
+	}
+}
+
+
+MinibillEnv* minibillEnvCreate( int numEnvs )
+{
+	assert( numEnvs > 0 );
+	return new MinibillEnv( numEnvs, nullptr );
+}
+
+
+void minibillEnvDestroy( MinibillEnv* env )
+{
+	delete env;
+}
+
+
+int minibillEnvCount( MinibillEnv const* env )
+{
+	return env->batch.size();
+}
+
+
+void minibillEnvSetThreads( MinibillEnv* env, int threads )
+{
+	env->workers = std::make_unique< Workers >( threads );
+}
+
+
+void minibillEnvSetRandomization( MinibillEnv* env, uint32_t seed, float rackJitter, float directionNoise, float powerNoise )
+{
+	env->seed = seed;
+	env->rackJitter = rackJitter;
+	env->directionNoise = directionNoise;
+	env->powerNoise = powerNoise;
+}
+
+
+void minibillEnvReset( MinibillEnv* env, float* observations )
+{
+	for ( int e = 0; e < env->batch.size(); e++ )
+	{
+		startEpisode( env, e );
+		writeObservation( env, e, observations + e * minibillEnvObservationSize );
+	}
+}
+
+
+void minibillEnvStep( MinibillEnv* env, float const* actions, float* observations, float* rewards, int* dones )
+{
+	int const numEnvs = env->batch.size();
+
+	for ( int e = 0; e < numEnvs; e++ )
+	{
+		float const* action = actions + e * minibillEnvActionSize;
+		strike( env, e, action[ 0 ], action[ 1 ], action[ 2 ] );
+	}
+
+	finishShots( env, rewards, dones );
+
+	for ( int e = 0; e < numEnvs; e++ )
+		writeObservation( env, e, observations + e * minibillEnvObservationSize );
+}
+
+
+size_t minibillEnvSharedSize( int numEnvs )
+{
+	size_t const state = alignedOffset( sizeof( float ) * TableBatch::storageSize( numEnvs ) );
+	size_t const envArray = alignedOffset( sizeof( float ) * numEnvs );
+	return alignedOffset( sizeof( MinibillEnvSharedHeader ) ) + state + 5 * envArray;
+}
+
+
+MinibillEnv* minibillEnvCreateShared( void* region, size_t regionSize, int numEnvs )
+{
+	assert( numEnvs > 0 );
+	if ( !region || regionSize < minibillEnvSharedSize( numEnvs ) || reinterpret_cast< uintptr_t >( region ) % 64 != 0 )
+		return nullptr;
+
+	MinibillEnvSharedHeader* header = static_cast< MinibillEnvSharedHeader* >( region );
+	int const stride = TableBatch::strideFor( numEnvs );
+	size_t const ballArray = sizeof( float ) * PhysicTable::numBalls * stride;
+	size_t const envArray = alignedOffset( sizeof( float ) * numEnvs );
+	size_t offset = alignedOffset( sizeof( MinibillEnvSharedHeader ) );
+
+	// the ball arrays are the TableBatch storage, in its order
+	header->magic = minibillEnvSharedMagic;
+	header->version = minibillEnvSharedVersion;
+	header->numEnvs = uint32_t( numEnvs );
+	header->numBalls = uint32_t( PhysicTable::numBalls );
+	header->command = minibillEnvCommandStep;
+	header->stride = uint32_t( stride );
+	header->positionXOffset = offset;	offset += ballArray;
+	header->positionYOffset = offset;	offset += ballArray;
+	header->inGameOffset = offset;		offset += ballArray;
+	header->speedXOffset = offset;		offset += ballArray;
+	header->speedYOffset = offset;		offset += ballArray;
+	offset = alignedOffset( offset );
+	header->directionXOffset = offset;	offset += envArray;
+	header->directionYOffset = offset;	offset += envArray;
+	header->powerOffset = offset;		offset += envArray;
+	header->rewardOffset = offset;		offset += envArray;
+	header->doneOffset = offset;		offset += envArray;
+	assert( offset == minibillEnvSharedSize( numEnvs ) );
+
+	char* base = static_cast< char* >( region );
+	std::fill_n( reinterpret_cast< float* >( base + header->directionXOffset ), 3 * envArray / sizeof( float ), 0.f );
+	std::fill_n( reinterpret_cast< float* >( base + header->rewardOffset ), numEnvs, 0.f );
+	std::fill_n( reinterpret_cast< int32_t* >( base + header->doneOffset ), numEnvs, 0 );
+
+	MinibillEnv* env = new MinibillEnv( numEnvs, reinterpret_cast< float* >( base + header->positionXOffset ) );
+	env->shared = header;
+	env->sharedDones.resize( numEnvs );
+
+	new ( &header->actionSequence ) std::atomic< uint32_t >( 0 );
+	new ( &header->observationSequence ) std::atomic< uint32_t >( 0 );
+	std::atomic_thread_fence( std::memory_order_release );
+	return env;
+}
+
+
+int minibillEnvServeShared( MinibillEnv* env )
+{
+	assert( env->shared );
+	MinibillEnvSharedHeader* header = env->shared;
+	std::atomic< uint32_t > &actionSequence = sharedCounter( header->actionSequence );
+	std::atomic< uint32_t > &observationSequence = sharedCounter( header->observationSequence );
+
+	uint32_t const served = observationSequence.load( std::memory_order_relaxed );
+	uint32_t const requested = waitForRequest( actionSequence, served );
+
+	uint32_t const command = header->command;
+	if ( command == minibillEnvCommandQuit )
+	{
+		observationSequence.store( requested, std::memory_order_release );
+		return 0;
+	}
+
+	int const numEnvs = env->batch.size();
+	char* base = reinterpret_cast< char* >( header );
+	float* rewards = reinterpret_cast< float* >( base + header->rewardOffset );
+	int32_t* dones = reinterpret_cast< int32_t* >( base + header->doneOffset );
+
+	if ( command == minibillEnvCommandReset )
+	{
+		for ( int e = 0; e < numEnvs; e++ )
+		{
+			startEpisode( env, e );
+			rewards[ e ] = 0.f;
+			dones[ e ] = 0;
+		}
+	}
+	else
+	{
+		float const* directionX = reinterpret_cast< float const* >( base + header->directionXOffset );
+		float const* directionY = reinterpret_cast< float const* >( base + header->directionYOffset );
+		float const* power = reinterpret_cast< float const* >( base + header->powerOffset );
+		for ( int e = 0; e < numEnvs; e++ )
+			strike( env, e, directionX[ e ], directionY[ e ], power[ e ] );
+
+		finishShots( env, rewards, env->sharedDones.data() );
+		std::copy( env->sharedDones.begin(), env->sharedDones.end(), dones );
+	}
+
+	observationSequence.store( requested, std::memory_order_release );
+	return 1;
+}
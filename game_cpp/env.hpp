@@ -0,0 +1,153 @@
+#pragma once
+
+
+//-------------------------------------------------------
+//	Batched training environment, C interface
+//
+//	One environment is one headless table. Every call works
+//	on the whole batch at once: the caller owns all buffers,
+//	they are laid out environment after environment.
+//
+//	observation, per ball:	x, y, inGame (0 or 1)
+//	action:					directionX, directionY, power in [0, 1]
+//
+//	A step plays one shot of the player ball to rest. An
+//	environment is done when the player ball is pocketed,
+//	all other balls are pocketed or the shot limit is hit;
+//	done environments are reset automatically and the
+//	returned observation is the first one of the new episode.
+//-------------------------------------------------------
+
+#include <stddef.h>
+#include <stdint.h>
+
+// MINIBILL_ENV_EXPORTS is defined by the minibill_env shared library targets
+#if defined( _WIN32 ) && defined( MINIBILL_ENV_EXPORTS )
+	#define MINIBILL_API __declspec( dllexport )
+#elif defined( __GNUC__ ) && defined( MINIBILL_ENV_EXPORTS )
+	#define MINIBILL_API __attribute__(( visibility( "default" ) ))
+#else
+	#define MINIBILL_API
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+enum
+{
+	minibillEnvNumBalls = 7,
+	minibillEnvObservationSize = minibillEnvNumBalls * 3,
+	minibillEnvActionSize = 3
+};
+
+typedef struct MinibillEnv MinibillEnv;
+
+MINIBILL_API MinibillEnv* minibillEnvCreate( int numEnvs );
+MINIBILL_API void minibillEnvDestroy( MinibillEnv* env );
+MINIBILL_API int minibillEnvCount( MinibillEnv const* env );
+
+// Worker threads playing the shots of a step, 1 by default, 0 for one per hardware
+// thread. Tables are stepped in blocks of 16, the blocks split evenly between the
+// workers, and results don't depend on the thread count. One thread plays 33k to 45k
+// random shots a second to rest with 4096 envs on current x64 cores, so hundreds of
+// thousands of transitions a second take several threads, each with enough blocks.
+MINIBILL_API void minibillEnvSetThreads( MinibillEnv* env, int threads );
+
+// randomisation is off by default; rack jitter is drawn per ( env, episode ) and the
+// shot noise per ( env, shot ), so a run is reproducible for the same seed and batch size
+MINIBILL_API void minibillEnvSetRandomization( MinibillEnv* env, uint32_t seed, float rackJitter, float directionNoise, float powerNoise );
+
+// observations: numEnvs * minibillEnvObservationSize floats
+MINIBILL_API void minibillEnvReset( MinibillEnv* env, float* observations );
+
+// actions: numEnvs * minibillEnvActionSize floats, rewards and dones: numEnvs entries each
+MINIBILL_API void minibillEnvStep( MinibillEnv* env, float const* actions, float* observations, float* rewards, int* dones );
+
+
+//-------------------------------------------------------
+//	Shared memory transport
+//
+//	The same batch can live in a region shared with an out
+//	of process trainer (shm_open + mmap, CreateFileMapping or
+//	anything else that maps the same pages in both processes).
+//	The host maps minibillEnvSharedSize bytes and hands them to
+//	minibillEnvCreateShared, which formats the region:
+//
+//	MinibillEnvSharedHeader
+//	float	positionX[ numBalls ][ stride ]		observations,
+//	float	positionY[ numBalls ][ stride ]		ball major so one
+//	float	inGame[ numBalls ][ stride ]		ball is contiguous
+//	float	speedX[ numBalls ][ stride ]		rest of the state
+//	float	speedY[ numBalls ][ stride ]
+//	float	directionX[ numEnvs ]				actions
+//	float	directionY[ numEnvs ]
+//	float	power[ numEnvs ]
+//	float	reward[ numEnvs ]
+//	int32_t	done[ numEnvs ]
+//
+//	The ball arrays are the simulation state itself, stepped
+//	in place with no copy: env e of ball i is at i * stride + e,
+//	stride is numEnvs rounded up to the vector width, the
+//	padding envs are never in game. Every array starts on a
+//	64 byte boundary, its byte offset from the region start is
+//	stored in the header.
+//
+//	Handshake: both sequence counters are lock free, address
+//	free 32 bit atomics, the trainer must use the same kind on
+//	the same words (std::atomic< uint32_t >, C11 atomic_uint).
+//	The trainer writes the actions
+//	and the command, then increments actionSequence.
+//	minibillEnvServeShared waits for it, executes the command in
+//	place and publishes observationSequence equal to the served
+//	actionSequence; the trainer reads the results once it sees
+//	that value. While the trainer is idle the server backs off
+//	from spinning to sleeps of up to a millisecond.
+//-------------------------------------------------------
+
+enum
+{
+	minibillEnvSharedMagic = 0x4c4c4942,	// "BILL"
+	minibillEnvSharedVersion = 2,
+
+	minibillEnvCommandStep = 0,
+	minibillEnvCommandReset = 1,
+	minibillEnvCommandQuit = 2
+};
+
+typedef struct MinibillEnvSharedHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numEnvs;
+	uint32_t numBalls;
+
+	uint32_t actionSequence;
+	uint32_t observationSequence;
+	uint32_t command;
+	uint32_t stride;
+
+	uint64_t positionXOffset;
+	uint64_t positionYOffset;
+	uint64_t inGameOffset;
+	uint64_t speedXOffset;
+	uint64_t speedYOffset;
+	uint64_t directionXOffset;
+	uint64_t directionYOffset;
+	uint64_t powerOffset;
+	uint64_t rewardOffset;
+	uint64_t doneOffset;
+} MinibillEnvSharedHeader;
+
+MINIBILL_API size_t minibillEnvSharedSize( int numEnvs );
+
+// formats the region and publishes the initial observations, returns null if the region is too small
+MINIBILL_API MinibillEnv* minibillEnvCreateShared( void* region, size_t regionSize, int numEnvs );
+
+// serves one trainer command, returns 0 once the trainer asked to quit
+MINIBILL_API int minibillEnvServeShared( MinibillEnv* env );
+
+#ifdef __cplusplus
+}
+#endif
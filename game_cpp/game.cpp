@@ -1,323 +1,261 @@
-
 #include <cassert>
 #include <cmath>
 #include <array>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <string>
 
 #include "../framework/scene.hpp"
 #include "../framework/game.hpp"
 #include "../framework/engine.hpp"
 
+#include "checksum.hpp"
+#include "params.hpp"
+#include "physics.hpp"
+#include "planner.hpp"
+#include "pocketability.hpp"
+#include "replay.hpp"
+#include "stress.hpp"
+
 
 //-------------------------------------------------------
-//	Basic Vector2 class
+//	Table logic
 //-------------------------------------------------------
 
-class Vector2
+class Table
 {
 public:
-	float x = 0.f;
-	float y = 0.f;
+	Table() = default;
+	Table( Table const& ) = delete;
 
-	constexpr Vector2() = default;
-	constexpr Vector2( float vx, float vy );
-	constexpr Vector2( Vector2 const &other ) = default;
-};
+	// the pocketability cache is kept in dataDirectory
+	void init( std::string const &dataDirectory, PhysicTable::Rack rack );
+	void deinit();
 
+	// alpha blends the ball meshes from the positions kept before the last step to the current ones
+	void keepPositions();
+	void updateMeshes( int pocketedMask, float alpha = 1.f );
 
-constexpr Vector2::Vector2( float vx, float vy ) :
-	x( vx ),
-	y( vy )
-{
-}
+	PhysicTable physics;
+	int ballToHit = 0;
 
-Vector2 normalizedVector(Vector2 v)
-{
-    float vectorLength = sqrt(v.x * v.x + v.y * v.y);
-    Vector2 newVector(v.x / vectorLength, v.y / vectorLength);
+	// layout only, kept across restarts
+	PocketField pocketField;
 
-    return newVector;
-}
+private:
+	std::array< Scene::Mesh*, 6 > pockets = {};
+	std::array< Scene::Mesh*, PhysicTable::numBalls > ballMeshes = {};
+	std::array< Vector2, PhysicTable::numBalls > previousPositions = {};
+};
 
-//-------------------------------------------------------
-//	game parameters
-//-------------------------------------------------------
 
-namespace Params
+void Table::init( std::string const &dataDirectory, PhysicTable::Rack rack )
 {
-	namespace System
+	for ( int i = 0; i < 6; i++ )
 	{
-		constexpr int targetFPS = 60;
+		assert( !pockets[ i ] );
+		pockets[ i ] = Scene::createPocketMesh( Params::Table::pocketRadius );
+		Scene::placeMesh( pockets[ i ], Params::Table::pocketsPositions[ i ].x, Params::Table::pocketsPositions[ i ].y, 0.f );
 	}
 
-	namespace Table
-	{
-		constexpr float width = 15.f;
-		constexpr float height = 8.f;
-		constexpr float pocketRadius = 0.4f;
+	if ( !pocketField.isBuilt() )
+		pocketField.init( ( dataDirectory + Params::Pocketability::cacheFile ).c_str() );
 
-		static constexpr std::array< Vector2, 6 > pocketsPositions =
-		{
-			Vector2{ -0.5f * width, -0.5f * height },
-			Vector2{ 0.f, -0.5f * height },
-			Vector2{ 0.5f * width, -0.5f * height },
-			Vector2{ -0.5f * width, 0.5f * height },
-			Vector2{ 0.f, 0.5f * height },
-			Vector2{ 0.5f * width, 0.5f * height }
-		};
-
-		static constexpr std::array< Vector2, 7 > ballsPositions =
-		{
-			// player ball
-			Vector2( -0.3f * width, 0.f ),
-			// other balls
-			Vector2( 0.2f * width, 0.f ),
-			Vector2( 0.25f * width, 0.05f * height ),
-			Vector2( 0.25f * width, -0.05f * height ),
-			Vector2( 0.3f * width, 0.1f * height ),
-			Vector2( 0.3f * width, 0.f ),
-			Vector2( 0.3f * width, -0.1f * height )
-		};
-
-	}
-
-	namespace Physics
-	{
-	    float frictionDeceleration = 0.003;
-	    float strikePower = 1.f;
-	}
+	physics.reset( rack );
+	keepPositions();
 
-	namespace Ball
+	for ( int i = 0; i < PhysicTable::numBalls; i++ )
 	{
-		constexpr float radius = 0.3f;
+		assert( !ballMeshes[ i ] );
+		ballMeshes[ i ] = Scene::createBallMesh( physics.balls[ i ].getRadius() );
 	}
+	updateMeshes( 0 );
 
-	namespace Shot
-	{
-		constexpr float chargeTime = 1.f;
-	}
+	ballToHit = 0;
 }
 
 
-class BillBall{
-    private:
-        Vector2 position;
-        Vector2 speed = Vector2(0, 0);
-
-    public:
-        Vector2 getPosition();
-        Vector2 getSpeed();
-        void setPosition(Vector2 newPosition);
-        void setSpeed(Vector2 newSpeed);
-        Vector2 getNextPosition(float dt);
-
-        void strike(Vector2 direction, float force);
-
-        Scene::Mesh* gameMesh;
-        Scene::Mesh* getMesh();
-
-        BillBall(Vector2 ballPosition, Scene::Mesh* mesh);
-};
-
-
-Vector2 BillBall::getPosition()
+void Table::deinit()
 {
-    return position;
-}
+	for ( Scene::Mesh* mesh : pockets )
+		Scene::destroyMesh( mesh );
+	pockets = {};
 
-Vector2 BillBall::getSpeed()
-{
-    return speed;
+	for ( Scene::Mesh* mesh : ballMeshes )
+		if ( mesh )
+			Scene::destroyMesh( mesh );
+	ballMeshes = {};
 }
 
-Scene::Mesh* BillBall::getMesh(){
-    return gameMesh;
-}
 
-Vector2 BillBall::getNextPosition(float dt)
+void Table::keepPositions()
 {
-    return Vector2(position.x + speed.x, position.y + speed.y);
-}
-
-void BillBall::setPosition(Vector2 newPosition){
-    position = Vector2(newPosition.x, newPosition.y);
+	for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		previousPositions[ i ] = physics.balls[ i ].getPosition();
 }
 
-void BillBall::setSpeed(Vector2 newSpeed){
-    speed.x = newSpeed.x;
-    speed.y = newSpeed.y;
-}
 
-BillBall::BillBall(Vector2 ballPosition, Scene::Mesh* mesh){
-    position = Vector2 ( ballPosition.x, ballPosition.y);
-    gameMesh = mesh;
-}
-
-void BillBall::strike(Vector2 direction, float power)
+void Table::updateMeshes( int pocketedMask, float alpha )
 {
-    direction = normalizedVector(direction);
-    speed.x +=  direction.x * power;
-    speed.y += direction.y * power;
+	for ( int i = 0; i < PhysicTable::numBalls; i++ )
+	{
+		if ( pocketedMask & ( 1 << i ) )
+		{
+			Scene::destroyMesh( ballMeshes[ i ] );
+			ballMeshes[ i ] = nullptr;
+		}
+		else if ( physics.inGame[ i ] )
+		{
+			Vector2 position = physics.balls[ i ].getPosition();
+			if ( alpha < 1.f )
+			{
+				position.x = previousPositions[ i ].x + ( position.x - previousPositions[ i ].x ) * alpha;
+				position.y = previousPositions[ i ].y + ( position.y - previousPositions[ i ].y ) * alpha;
+			}
+			Scene::placeMesh( ballMeshes[ i ], position.x, position.y, 0.f );
+		}
+	}
 }
 
 
 //-------------------------------------------------------
-//	Table logic
+//	game public interface
 //-------------------------------------------------------
 
-class Table
+namespace Game
 {
-public:
-	Table() = default;
-	Table( Table const& ) = delete;
+	Table table;
 
-	void init();
-	void deinit();
+	bool isChargingShot = false;
+	float shotChargeProgress = 0.f;
 
-	std::array<BillBall*, 7> billBalls = {};
-	BillBall* ballToHit;
+	float timeScale = 1.f;
+	float playback = 0.f;	// display time past the last step, in steps, within ( -1, 0 ]
 
-private:
-	std::array< Scene::Mesh*, 6 > pockets = {};
-};
+	uint32_t frame = 0;
+	Checksum::Frame checksum;
+	std::ofstream checksumLog;
+	Replay::Writer replayLog;
+	std::string dataDirectory;
+	PhysicTable::Rack rack = PhysicTable::Rack::standard;
 
+	// turns pass when the table comes to rest after a shot
+	bool botOpponent = false;
+	bool botTurn = false;
+	bool shotInProgress = false;
+	Planner planner;
+	std::future< Planner::Result > botShot;
 
-void Table::init()
-{
-	for ( int i = 0; i < 6; i++ )
-	{
-		assert( !pockets[ i ] );
-		pockets[ i ] = Scene::createPocketMesh( Params::Table::pocketRadius );
-		Scene::placeMesh( pockets[ i ], Params::Table::pocketsPositions[ i ].x, Params::Table::pocketsPositions[ i ].y, 0.f );
-	}
 
-	for ( int i = 0; i < 7; i++ )
+	// false if the table rejects the shot
+	bool strike( Shot const &shot )
 	{
-        Scene::Mesh* ballMesh = Scene::createBallMesh( Params::Ball::radius );
-        Scene::placeMesh(ballMesh, Params::Table::ballsPositions[ i ].x, Params::Table::ballsPositions[ i ].y, 0.f );
-
-        BillBall* newBall = new BillBall( Vector2(Params::Table::ballsPositions[ i ].x  , Params::Table::ballsPositions[ i ].y), ballMesh);
+		if ( !table.physics.strike( shot ) )
+			return false;
+		replayLog.strike( shot );
+		shotInProgress = true;
+		return true;
+	}
 
-		billBalls[ i ] = newBall;
 
+	// plans in the background so the table keeps rendering, strikes once the plan is ready
+	void updateBot()
+	{
+		if ( !botShot.valid() )
+		{
+			PhysicTable const physics = table.physics;
+			auto const deadline = Planner::Clock::now() + std::chrono::duration_cast< Planner::Clock::duration >( std::chrono::duration< float >( Params::Bot::thinkTime ) );
+			botShot = std::async( std::launch::async, [ physics, deadline ]() { return planner.plan( physics, deadline ); } );
+			return;
+		}
+
+		if ( botShot.wait_for( std::chrono::seconds( 0 ) ) != std::future_status::ready )
+			return;
+
+		// without a plan the table can take, the turn goes back to the player instead of
+		// replanning every frame
+		Planner::Result const result = botShot.get();
+		if ( !result.found || !strike( result.shot ) )
+			botTurn = false;
 	}
 
-	ballToHit = billBalls[ 0 ];
-}
 
+	int advancePhysics()
+	{
+		table.keepPositions();
+		int const pocketedMask = table.physics.step();
+		replayLog.step( table.physics );
 
-void Table::deinit()
-{
-	for ( Scene::Mesh* mesh : pockets )
-		Scene::destroyMesh( mesh );
-	pockets = {};
-}
+		frame++;
+		checksum = Checksum::compute( table.physics, frame, checksum.table );
+		if ( checksumLog.is_open() )
+			Checksum::write( checksumLog, checksum );
 
-//-------------------------------------------------------
-//	physical calculations
-//-------------------------------------------------------
+		return pocketedMask;
+	}
 
-namespace PhysicEvents
-{
-    Vector2 vectorProjecction(Vector2 a, Vector2 b)
-    {
-        float pr = (a.x*b.x+a.y*b.y)/(sqrt(b.x*b.x+b.y*b.y));
-
-        Vector2 t = normalizedVector(b);
-
-        t.x = t.x * pr;
-        t.y = t.y * pr;
-
-        return t;
-    }
-
-
-    void ricochet(BillBall*curBall)
-    {
-        float x = curBall->getPosition().x, y = curBall->getPosition().y;
-
-        if (x + Params::Ball::radius > 0.5f * Params::Table::width)
-        {
-            float difference = x + Params::Ball::radius - 0.5f * Params::Table::width;
-            curBall->setPosition(Vector2(x - difference * 2, y));
-            curBall->setSpeed(Vector2( -curBall->getSpeed().x, curBall->getSpeed().y ));
-        }
-
-        if (curBall->getPosition().x - Params::Ball::radius < -0.5f * Params::Table::width)
-        {
-            float difference = - 0.5f * Params::Table::width - x + Params::Ball::radius;
-            curBall->setPosition(Vector2(x + difference * 2, y));
-            curBall->setSpeed(Vector2( -curBall->getSpeed().x, curBall->getSpeed().y ));
-        }
-
-        if (curBall->getPosition().y + Params::Ball::radius > 0.5f * Params::Table::height)
-        {
-            float difference = y + Params::Ball::radius - 0.5f * Params::Table::height;
-            curBall->setPosition(Vector2(x, y - difference * 2));
-            curBall->setSpeed(Vector2( curBall->getSpeed().x, -curBall->getSpeed().y ));
-        }
-
-        if (curBall->getPosition().y - Params::Ball::radius < -0.5f * Params::Table::height)
-        {
-            float difference = - 0.5f * Params::Table::height - y + Params::Ball::radius;
-            curBall->setPosition(Vector2(x, y + difference * 2));
-            curBall->setSpeed(Vector2( curBall->getSpeed().x, -curBall->getSpeed().y ));
-        }
-    }
-
-    void collide(BillBall* ball1, BillBall* ball2)
-    {
-        float x1 = ball1->getPosition().x, x2 = ball2->getPosition().x;
-        float y1 = ball1->getPosition().y, y2 = ball2->getPosition().y;
-
-        Vector2 guideVector = Vector2( x2 - x1, y2 - y1 );
-
-        Vector2 g1 = vectorProjecction(ball1->getSpeed(), guideVector);
-        Vector2 g2 = vectorProjecction(ball2->getSpeed(), guideVector);
-
-        Vector2 newSpeed1 = Vector2(ball1->getSpeed().x - g1.x + g2.x, ball1->getSpeed().y - g1.y + g2.y );
-        Vector2 newSpeed2 = Vector2(ball2->getSpeed().x + g1.x - g2.x, ball2->getSpeed().y + g1.y - g2.y );
-
-        ball1->setSpeed(newSpeed1);
-        ball2->setSpeed(newSpeed2);
-    }
-}
 
+	// same steps and checksums as playing the shot out, only the meshes wait for the rest
+	void skipShot()
+	{
+		int pocketedMask = 0;
+		for ( int i = 0; i < Params::Env::maxShotSteps && !table.physics.isResting(); i++ )
+			pocketedMask |= advancePhysics();
+		table.keepPositions();
+		table.updateMeshes( pocketedMask );
+		playback = 0.f;
+	}
 
-//-------------------------------------------------------
-//	game public interface
-//-------------------------------------------------------
 
-namespace Game
-{
-	Table table;
+	// Display time runs timeScale steps per frame. A step is taken as soon as the display
+	// time passes the last one and the meshes are blended towards it, so at 1x every frame
+	// takes one step and shows its result, and slower scales glide between steps.
+	void stepPhysics()
+	{
+		playback += timeScale;
 
-	bool isChargingShot = false;
-	float shotChargeProgress = 0.f;
+		int pocketedMask = 0;
+		for ( int steps = 0; playback > 0.f && steps < Params::Playback::maxStepsPerFrame; steps++ )
+		{
+			pocketedMask |= advancePhysics();
+			playback -= 1.f;
+		}
+		// behind the cap the display drops time instead of catching up later
+		playback = std::max( std::min( playback, 0.f ), -1.f );
+
+		table.updateMeshes( pocketedMask, 1.f + playback );
+	}
 
 
 	void init()
 	{
 		Engine::setTargetFPS( Params::System::targetFPS );
 		Scene::setupBackground( Params::Table::width, Params::Table::height );
-		table.init();
+		table.init( dataDirectory, rack );
+		planner.setPocketField( &table.pocketField );
+
+		frame = 0;
+		checksum = Checksum::compute( table.physics, frame, 0 );
+		if ( checksumLog.is_open() )
+			Checksum::writeReset( checksumLog );
+		playback = 0.f;
+		replayLog.reset( table.physics );
+
+		botTurn = false;
+		shotInProgress = false;
 	}
 
 
 	void deinit()
 	{
+		// waits for a plan in flight, it reads nothing but its own copy of the table
+		botShot = {};
 		table.deinit();
 	}
 
-    float distance(Vector2 v1, Vector2 v2)
-    {
-        return sqrt( (v1.x-v2.x)*(v1.x-v2.x) + (v1.y-v2.y)*(v1.y-v2.y) );
-    }
-
-    void score(int ballIndex)
-    {
-        Scene::destroyMesh(table.billBalls[ ballIndex ]->getMesh());
-        table.billBalls[ ballIndex ] = NULL;
-    }
 
 	void update( float dt )
 	{
@@ -325,84 +263,132 @@ namespace Game
 			shotChargeProgress = std::min( shotChargeProgress + dt / Params::Shot::chargeTime, 1.f );
 		Scene::updateProgressBar( shotChargeProgress );
 
-            for (int i = 0; i < table.billBalls.size(); i++)
-            {
-                BillBall* curBall = table.billBalls[ i ];
-                if (curBall != NULL)
-                {
-                    bool scored = false;
-                    Vector2 positionToMove = curBall->getNextPosition(dt);
-
-                    for (int j = 0; j < 6; j++)
-                    {
-                        Vector2 pocketVector = Vector2(Params::Table::pocketsPositions[ j ].x, Params::Table::pocketsPositions[ j ].y);
-                        if ( distance(positionToMove, pocketVector) < Params::Table::pocketRadius )
-                        {
-                            scored = true;
-                            score(i);
-                        }
-                    }
-
-                    if (!scored)
-                    {
-                        float vx = curBall->getSpeed().x;
-                        float vy = curBall->getSpeed().y;
-
-                        if ( ( vx != 0 ) || (vy != 0 ) )
-                            if ( ( vx * vx + vy * vy ) <= Params::Physics::frictionDeceleration * Params::Physics::frictionDeceleration * 1.1f)
-                                curBall->setSpeed( Vector2(0,0) );
-                            else
-                            {
-                                Vector2 deceleration = normalizedVector( curBall->getSpeed() );
-                                deceleration.x = -deceleration.x * Params::Physics::frictionDeceleration;
-                                deceleration.y = -deceleration.y * Params::Physics::frictionDeceleration;
-
-                                curBall->setSpeed(Vector2( vx + deceleration.x, vy + deceleration.y )  );
-                            }
-
-                        if ((positionToMove.x + Params::Ball::radius > 0.5f * Params::Table::width) ||
-                            (positionToMove.x - Params::Ball::radius < -0.5f * Params::Table::width) ||
-                            (positionToMove.y + Params::Ball::radius > 0.5f * Params::Table::height) ||
-                            (positionToMove.y - Params::Ball::radius < -0.5f * Params::Table::height))
-                            {
-                                curBall->setPosition(positionToMove);
-                                PhysicEvents::ricochet(curBall);
-                                positionToMove = curBall->getPosition();
-                            }
-
-                        for (int l = i+1; l < table.billBalls.size(); l++)
-                        {
-                            if ((l != i) && (table.billBalls[ l ] != NULL))
-                                if ( distance(positionToMove, table.billBalls[ l ]->getPosition() ) <= 2 * Params::Ball::radius )
-                                {
-                                    positionToMove = curBall->getPosition();
-                                    PhysicEvents::collide(curBall, table.billBalls[ l ]);
-                                }
-                        }
-
-                        curBall->setPosition(positionToMove);
-                        Scene::placeMesh(table.billBalls[i]->getMesh(), curBall->getPosition().x, curBall->getPosition().y, 0.f);
-                    }
-
-                }
-            }
+		stepPhysics();
 
+		if ( shotInProgress && table.physics.isResting() )
+		{
+			shotInProgress = false;
+			botTurn = botOpponent && !botTurn;
+		}
+		if ( botTurn && !shotInProgress )
+			updateBot();
 	}
 
 
 	void mouseButtonPressed( float x, float y )
 	{
-		isChargingShot = true;
+		// a click while the balls roll resolves the shot at once instead of charging the next
+		if ( shotInProgress )
+		{
+			skipShot();
+			return;
+		}
+		isChargingShot = !botTurn;
 	}
 
 
 	void mouseButtonReleased( float x, float y )
 	{
-
-		Vector2 direction(x - table.ballToHit->getPosition().x, y - table.ballToHit->getPosition().y);
-        table.ballToHit->strike(direction, shotChargeProgress * Params::Physics::strikePower);
+		if ( isChargingShot )
+		{
+			Vector2 position = table.physics.balls[ table.ballToHit ].getPosition();
+			Shot shot;
+			shot.direction = Vector2( x - position.x, y - position.y );
+			shot.power = shotChargeProgress;
+			strike( shot );
+		}
 
 		isChargingShot = false;
 		shotChargeProgress = 0.f;
 	}
+
+
+	void setTimeScale( float scale )
+	{
+		timeScale = std::max( std::min( scale, Params::Playback::maxTimeScale ), Params::Playback::minTimeScale );
+	}
+
+
+	void setDataDirectory( char const* path )
+	{
+		dataDirectory = path ? path : "";
+	}
+
+
+	void setMixedRack( bool enabled )
+	{
+		rack = enabled ? PhysicTable::Rack::mixed : PhysicTable::Rack::standard;
+	}
+
+
+	void setBotOpponent( bool enabled )
+	{
+		botOpponent = enabled;
+		botTurn = false;
+	}
+
+
+	uint64_t stateChecksum()
+	{
+		return checksum.table;
+	}
+
+
+	void recordChecksums( char const* path )
+	{
+		checksumLog.close();
+		if ( path )
+			checksumLog.open( path, std::ios::out | std::ios::trunc );
+	}
+
+
+	void recordReplay( char const* path )
+	{
+		replayLog.close();
+		if ( path )
+			replayLog.open( path );
+	}
+
+
+	void runStress( int balls, int steps, int threads, int reorderInterval )
+	{
+		if ( steps <= 0 )
+			steps = Params::Stress::steps;
+
+		Workers workers( threads );
+		Stress::Table stress;
+		stress.reset( balls );
+		if ( reorderInterval >= 0 )
+			stress.setReorderInterval( reorderInterval );
+
+		int64_t contacts = 0, islands = 0, awake = 0, sweeps = 0, crossings = 0, droppedPairs = 0;
+		int colours = 0;
+		// storage distance between touching balls, the first step is before any reorder and the
+		// last is the last one with contacts
+		double firstSpan = 0.0, lastSpan = 0.0;
+		auto const start = std::chrono::steady_clock::now();
+		for ( int i = 0; i < steps; i++ )
+		{
+			Stress::StepStats const stats = stress.step( workers );
+			contacts += stats.contacts;
+			islands += stats.islands;
+			awake += stats.awake;
+			sweeps += stats.sweeps;
+			crossings += stats.crossings;
+			colours = std::max( colours, stats.colours );
+			droppedPairs += stats.droppedPairs;
+			if ( stats.contacts > 0 )
+				lastSpan = double( stats.contactSpan ) / stats.contacts;
+			if ( i == 0 )
+				firstSpan = lastSpan;
+		}
+		double const seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+		std::printf( "stress: %d balls, %d steps, %d threads, %.3f ms per step, per step %.1f awake %.1f crossings %.1f contacts %.1f islands, "
+			"%.2f sweeps per island, %d colours at most, %lld cached pairs dropped, %.1f storage distance between touching balls on the first step "
+			"and %.1f on the last with contacts, checksum %016llx\n",
+			balls, steps, workers.count(), 1000.0 * seconds / steps, double( awake ) / steps, double( crossings ) / steps, double( contacts ) / steps,
+			double( islands ) / steps, double( sweeps ) / std::max( islands, int64_t( 1 ) ), colours, static_cast< long long >( droppedPairs ),
+			firstSpan, lastSpan, static_cast< unsigned long long >( stress.checksum() ) );
+	}
 }
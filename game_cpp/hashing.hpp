@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+
+//-------------------------------------------------------
+//	Integer hashing helpers
+//-------------------------------------------------------
+
+namespace Hashing
+{
+	// splitmix64 finaliser, a cheap bijective 64 bit mixer
+	inline uint64_t mix( uint64_t value )
+	{
+		value ^= value >> 30;
+		value *= 0xBF58476D1CE4E5B9ull;
+		value ^= value >> 27;
+		value *= 0x94D049BB133111EBull;
+		value ^= value >> 31;
+		return value;
+	}
+}
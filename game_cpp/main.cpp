@@ -1,10 +1,53 @@
-
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
 #include "../framework/engine.hpp"
+#include "../framework/game.hpp"
 
 
-int main()
+int main( int argc, char* argv[] )
 {
+	int stressBalls = 0;
+	int stressSteps = 0;
+	int threads = 0;
+	int stressReorder = -1;
+
+	// the cache goes next to the executable, not wherever it was started from
+	std::string const executable = argc > 0 ? argv[ 0 ] : "";
+	size_t const separator = executable.find_last_of( "/\\" );
+	Game::setDataDirectory( separator == std::string::npos ? "" : executable.substr( 0, separator + 1 ).c_str() );
+
+	for ( int i = 1; i < argc; i++ )
+	{
+		if ( std::strcmp( argv[ i ], "--checksums" ) == 0 && i + 1 < argc )
+			Game::recordChecksums( argv[ ++i ] );
+		else if ( std::strcmp( argv[ i ], "--replay" ) == 0 && i + 1 < argc )
+			Game::recordReplay( argv[ ++i ] );
+		else if ( std::strcmp( argv[ i ], "--bot" ) == 0 )
+			Game::setBotOpponent( true );
+		else if ( std::strcmp( argv[ i ], "--mixed" ) == 0 )
+			Game::setMixedRack( true );
+		else if ( std::strcmp( argv[ i ], "--time-scale" ) == 0 && i + 1 < argc )
+			Game::setTimeScale( float( std::atof( argv[ ++i ] ) ) );
+		else if ( std::strcmp( argv[ i ], "--stress" ) == 0 && i + 1 < argc )
+			stressBalls = std::atoi( argv[ ++i ] );
+		else if ( std::strcmp( argv[ i ], "--stress-steps" ) == 0 && i + 1 < argc )
+			stressSteps = std::atoi( argv[ ++i ] );
+		else if ( std::strcmp( argv[ i ], "--stress-reorder" ) == 0 && i + 1 < argc )
+			stressReorder = std::atoi( argv[ ++i ] );
+		else if ( std::strcmp( argv[ i ], "--threads" ) == 0 && i + 1 < argc )
+			threads = std::atoi( argv[ ++i ] );
+	}
+
+	if ( stressBalls > 0 )
+	{
+		Game::runStress( stressBalls, stressSteps, threads, stressReorder );
+		return 0;
+	}
+
 	Engine::run();
+	Game::recordChecksums( nullptr );
+	Game::recordReplay( nullptr );
 	return 0;
 }
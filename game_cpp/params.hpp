@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "vector2.hpp"
+
+
+//-------------------------------------------------------
+//	game parameters
+//-------------------------------------------------------
+
+namespace Params
+{
+	namespace System
+	{
+		constexpr int targetFPS = 60;
+	}
+
+	namespace Table
+	{
+		constexpr float width = 15.f;
+		constexpr float height = 8.f;
+		constexpr float pocketRadius = 0.4f;
+
+		static constexpr std::array< Vector2, 6 > pocketsPositions =
+		{
+			Vector2{ -0.5f * width, -0.5f * height },
+			Vector2{ 0.f, -0.5f * height },
+			Vector2{ 0.5f * width, -0.5f * height },
+			Vector2{ -0.5f * width, 0.5f * height },
+			Vector2{ 0.f, 0.5f * height },
+			Vector2{ 0.5f * width, 0.5f * height }
+		};
+
+		static constexpr std::array< Vector2, 7 > ballsPositions =
+		{
+			// player ball
+			Vector2( -0.3f * width, 0.f ),
+			// other balls
+			Vector2( 0.2f * width, 0.f ),
+			Vector2( 0.25f * width, 0.05f * height ),
+			Vector2( 0.25f * width, -0.05f * height ),
+			Vector2( 0.3f * width, 0.1f * height ),
+			Vector2( 0.3f * width, 0.f ),
+			Vector2( 0.3f * width, -0.1f * height )
+		};
+
+		// ball radii of the mixed rack over Ball::radius, the player ball keeps its size
+		static constexpr std::array< float, 7 > mixedRadiusScales = { 1.f, 1.3f, 0.8f, 1.2f, 0.9f, 1.1f, 0.85f };
+	}
+
+	namespace Physics
+	{
+	    inline float frictionDeceleration = 0.003f;
+	    inline float strikePower = 1.f;
+
+		// adaptive steps: the fastest ball moves at most courantNumber radii per step, the
+		// step is a power of two of the base step within [ minStepSize, maxStepSize ]; the
+		// base step itself after a strike, it's the reference the game is tuned on
+		constexpr float courantNumber = 1.f;
+		constexpr float minStepSize = 1.f;
+		constexpr float maxStepSize = 32.f;
+		// balls still over courantNumber radii per step move in substeps, at most this many
+		constexpr int maxSubsteps = 16;
+	}
+
+	namespace Ball
+	{
+		constexpr float radius = 0.3f;
+		constexpr float mass = 1.f;
+	}
+
+	namespace Shot
+	{
+		constexpr float chargeTime = 1.f;
+	}
+
+	namespace Random
+	{
+		// half extent of the uniform offset added to the rack balls
+		constexpr float rackJitter = 0.05f;
+		// standard deviations of the shot execution noise
+		constexpr float directionNoise = 0.01f;	// radians
+		constexpr float powerNoise = 0.02f;
+	}
+
+	namespace Env
+	{
+		// a shot that hasn't settled after this many steps is cut off
+		constexpr int maxShotSteps = 2000;
+		constexpr int maxEpisodeShots = 50;
+		constexpr float scratchPenalty = 1.f;
+	}
+
+	namespace Playback
+	{
+		constexpr float minTimeScale = 0.1f;
+		constexpr float maxTimeScale = 16.f;
+		// fast forward past this many steps a frame runs slower than asked
+		constexpr int maxStepsPerFrame = 16;
+	}
+
+	namespace Replay
+	{
+		// steps between keyframes, the most a seek has to simulate
+		constexpr uint32_t keyframeInterval = 300;
+	}
+
+	namespace Bot
+	{
+		constexpr float thinkTime = 0.5f;	// seconds
+		constexpr int threads = 0;			// 0 uses every hardware thread
+		// search shape: candidate shots per position, shots per sequence, random shots after a leaf
+		constexpr int branching = 16;
+		constexpr int maxDepth = 3;
+		constexpr int rolloutShots = 1;
+		constexpr float minPower = 0.2f;
+		// how many of the candidates come from the ghost ball generator, the rest are random
+		constexpr int ghostCandidates = 8;
+		// object ball speed squared over what it needs to reach the pocket
+		constexpr float potSpeedMargin = 2.f;
+		// score factor of a pot whose cue ball deflection heads into a pocket
+		constexpr float scratchRiskFactor = 0.25f;
+		constexpr float discount = 0.9f;
+		constexpr float exploration = 1.f;
+		constexpr float virtualLoss = 1.f;
+	}
+
+	namespace Screening
+	{
+		// base steps per coarse step
+		constexpr int stepSize = 4;
+		// how many of the best coarse shots are re-simulated in full
+		constexpr int topK = 16;
+		// every n-th screened out shot is re-simulated too, to measure what the screen misses
+		constexpr int auditInterval = 16;
+		// random shots screened for the planner's root candidates
+		constexpr int rootPool = 256;
+	}
+
+	namespace Pocketability
+	{
+		// grid cell per ball radius over the table, angle bins per full turn
+		constexpr float cellSize = Ball::radius;
+		constexpr int angleBins = 256;
+		// cache of the built grid, in the game's data directory next to the executable
+		constexpr char const* cacheFile = "pocketability.bin";
+	}
+
+	namespace Transposition
+	{
+		// quantisation of the keys, outcomes are stored on the same position grid
+		constexpr float positionCell = 1.f / 2048.f;
+		constexpr int angleSteps = 4096;
+		constexpr int powerSteps = 256;
+		// the cache holds 2^cacheSizeLog2 entries of one cache line each
+		constexpr int cacheSizeLog2 = 16;
+	}
+
+	namespace Stress
+	{
+		// one giant table of the table's proportions, sized for the ball count
+		constexpr int balls = 20000;
+		constexpr float density = 0.35f;		// ball area over table area
+		constexpr float maxInitialSpeed = 0.5f;
+		// standard, snooker and novelty balls and the share of each, of Ball::mass scaled by volume
+		constexpr std::array< float, 3 > radii = { Ball::radius, 0.92f * Ball::radius, 3.f * Ball::radius };
+		constexpr std::array< float, 3 > radiusShares = { 0.78f, 0.2f, 0.02f };
+		constexpr int steps = 600;
+		// bigger islands are split by colours across the workers instead of taking one
+		constexpr int maxIslandContacts = 1024;
+		// sequential impulse sweeps over an island, fewer once no impulse changes by the tolerance
+		constexpr int solverSweeps = 16;
+		constexpr float solverTolerance = 1e-6f;
+		// steps between Morton order re-sorts of the ball storage, 0 never sorts
+		constexpr int reorderInterval = 60;
+	}
+}
@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "physics.hpp"
+#include "physics_step.hpp"
+#include "prediction.hpp"
+
+
+//-------------------------------------------------------
+//	Billiard ball
+//-------------------------------------------------------
+
+Vector2 BillBall::getPosition() const
+{
+    return position;
+}
+
+Vector2 BillBall::getSpeed() const
+{
+    return speed;
+}
+
+Vector2 BillBall::getNextPosition() const
+{
+    return Vector2(position.x + speed.x, position.y + speed.y);
+}
+
+float BillBall::getRadius() const
+{
+    return radius;
+}
+
+float BillBall::getMass() const
+{
+    return mass;
+}
+
+void BillBall::setRadius(float newRadius){
+    radius = newRadius;
+}
+
+void BillBall::setMass(float newMass){
+    mass = newMass;
+}
+
+void BillBall::setPosition(Vector2 newPosition){
+    position = Vector2(newPosition.x, newPosition.y);
+}
+
+void BillBall::setSpeed(Vector2 newSpeed){
+    speed.x = newSpeed.x;
+    speed.y = newSpeed.y;
+}
+
+BillBall::BillBall(Vector2 ballPosition){
+    position = Vector2 ( ballPosition.x, ballPosition.y);
+}
+
+void BillBall::strike(Vector2 direction, float power)
+{
+    direction = normalizedVector(direction);
+    speed.x +=  direction.x * power;
+    speed.y += direction.y * power;
+}
+
+
+//-------------------------------------------------------
+//	Headless table physics
+//-------------------------------------------------------
+
+void PhysicTable::reset( Rack rack )
+{
+	for ( int i = 0; i < numBalls; i++ )
+	{
+		balls[ i ] = BillBall( Params::Table::ballsPositions[ i ] );
+		inGame[ i ] = true;
+
+		if ( rack == Rack::mixed )
+		{
+			float const scale = Params::Table::mixedRadiusScales[ i ];
+			balls[ i ].setRadius( Params::Ball::radius * scale );
+			balls[ i ].setMass( Params::Ball::mass * scale * scale * scale );
+		}
+	}
+}
+
+
+bool PhysicTable::strike( Shot const &shot )
+{
+	if ( !inGame[ 0 ] || ( shot.direction.x == 0.f && shot.direction.y == 0.f ) )
+		return false;
+	float const power = std::max( std::min( shot.power, 1.f ), 0.f );
+	balls[ 0 ].strike( shot.direction, power * Params::Physics::strikePower );
+	return true;
+}
+
+
+int PhysicTable::step()
+{
+	return stepEvents().pocketedMask;
+}
+
+
+StepEvents PhysicTable::stepEvents()
+{
+	if ( isUniform() )
+		return stepWith< PhysicStep::Standard >();
+	return stepWith< PhysicStep::Mixed >();
+}
+
+
+namespace
+{
+	// the one run time choice of the kernel, nothing under it branches on the step
+	template< typename Policies >
+	StepEvents stepKernel( PhysicTable &table, float stepSize, bool substeps )
+	{
+		if ( stepSize == 1.f )
+		{
+			if ( substeps )
+				return table.stepWith< Policies, PhysicStep::CourantSubsteps >( PhysicStep::BaseStep() );
+			return table.stepWith< Policies >( PhysicStep::BaseStep() );
+		}
+
+		PhysicStep::ClosedFormStep const step = { stepSize };
+		if ( substeps )
+			return table.stepWith< Policies, PhysicStep::CourantSubsteps >( step );
+		return table.stepWith< Policies, PhysicStep::NoSubsteps >( step );
+	}
+}
+
+
+StepEvents PhysicTable::stepEvents( float stepSize, bool substeps )
+{
+	if ( isUniform() )
+		return stepKernel< PhysicStep::Standard >( *this, stepSize, substeps );
+	return stepKernel< PhysicStep::Mixed >( *this, stepSize, substeps );
+}
+
+
+float PhysicTable::adaptiveStepSize() const
+{
+	// the smallest ball in game bounds the step, the mixed rack has some under Params::Ball::radius
+	float maxSpeedSquared = 0.f;
+	float minRadius = std::numeric_limits< float >::max();
+	for ( int i = 0; i < numBalls; i++ )
+	{
+		if ( !inGame[ i ] )
+			continue;
+		Vector2 const speed = balls[ i ].getSpeed();
+		maxSpeedSquared = std::max( maxSpeedSquared, speed.x * speed.x + speed.y * speed.y );
+		minRadius = std::min( minRadius, balls[ i ].getRadius() );
+	}
+
+	float const limit = Params::Physics::courantNumber * minRadius;
+	float stepSize = Params::Physics::maxStepSize;
+	while ( stepSize > Params::Physics::minStepSize && stepSize * stepSize * maxSpeedSquared > limit * limit )
+		stepSize *= 0.5f;
+
+	// a stretch of pure friction is one closed form step however far the balls go
+	return std::max( stepSize, float( Prediction::stepsWithoutEvents( *this ) ) );
+}
+
+
+bool PhysicTable::isResting() const
+{
+	for ( int i = 0; i < numBalls; i++ )
+	{
+		if ( inGame[ i ] && ( balls[ i ].getSpeed().x != 0.f || balls[ i ].getSpeed().y != 0.f ) )
+			return false;
+	}
+	return true;
+}
+
+
+bool PhysicTable::isUniform() const
+{
+	for ( BillBall const &ball : balls )
+	{
+		if ( ball.getRadius() != Params::Ball::radius || ball.getMass() != Params::Ball::mass )
+			return false;
+	}
+	return true;
+}
+
+
+int PhysicTable::inGameMask() const
+{
+	int mask = 0;
+	for ( int i = 0; i < numBalls; i++ )
+	{
+		if ( inGame[ i ] )
+			mask |= 1 << i;
+	}
+	return mask;
+}
+
+
+//-------------------------------------------------------
+//	physical calculations
+//-------------------------------------------------------
+
+namespace PhysicEvents
+{
+    Vector2 vectorProjecction(Vector2 a, Vector2 b)
+    {
+        float pr = (a.x*b.x+a.y*b.y)/(std::sqrt(b.x*b.x+b.y*b.y));
+
+        Vector2 t = normalizedVector(b);
+
+        t.x = t.x * pr;
+        t.y = t.y * pr;
+
+        return t;
+    }
+
+
+    void ricochet(BillBall*curBall)
+    {
+        float x = curBall->getPosition().x, y = curBall->getPosition().y;
+        float radius = curBall->getRadius();
+
+        if (x + radius > 0.5f * Params::Table::width)
+        {
+            float difference = x + radius - 0.5f * Params::Table::width;
+            curBall->setPosition(Vector2(x - difference * 2, y));
+            curBall->setSpeed(Vector2( -curBall->getSpeed().x, curBall->getSpeed().y ));
+        }
+
+        if (curBall->getPosition().x - radius < -0.5f * Params::Table::width)
+        {
+            float difference = - 0.5f * Params::Table::width - x + radius;
+            curBall->setPosition(Vector2(x + difference * 2, y));
+            curBall->setSpeed(Vector2( -curBall->getSpeed().x, curBall->getSpeed().y ));
+        }
+
+        if (curBall->getPosition().y + radius > 0.5f * Params::Table::height)
+        {
+            float difference = y + radius - 0.5f * Params::Table::height;
+            curBall->setPosition(Vector2(x, y - difference * 2));
+            curBall->setSpeed(Vector2( curBall->getSpeed().x, -curBall->getSpeed().y ));
+        }
+
+        if (curBall->getPosition().y - radius < -0.5f * Params::Table::height)
+        {
+            float difference = - 0.5f * Params::Table::height - y + radius;
+            curBall->setPosition(Vector2(x, y + difference * 2));
+            curBall->setSpeed(Vector2( curBall->getSpeed().x, -curBall->getSpeed().y ));
+        }
+    }
+
+    template<>
+    void collide< UniformBalls >(BillBall* ball1, BillBall* ball2)
+    {
+        float x1 = ball1->getPosition().x, x2 = ball2->getPosition().x;
+        float y1 = ball1->getPosition().y, y2 = ball2->getPosition().y;
+
+        Vector2 guideVector = Vector2( x2 - x1, y2 - y1 );
+
+        Vector2 g1 = vectorProjecction(ball1->getSpeed(), guideVector);
+        Vector2 g2 = vectorProjecction(ball2->getSpeed(), guideVector);
+
+        Vector2 newSpeed1 = Vector2(ball1->getSpeed().x - g1.x + g2.x, ball1->getSpeed().y - g1.y + g2.y );
+        Vector2 newSpeed2 = Vector2(ball2->getSpeed().x + g1.x - g2.x, ball2->getSpeed().y + g1.y - g2.y );
+
+        ball1->setSpeed(newSpeed1);
+        ball2->setSpeed(newSpeed2);
+    }
+
+
+	// Elastic impulse along the line of centres, j = 2 m1 m2 / ( m1 + m2 ) times the
+	// closing speed, each ball takes it over its own mass.
+	template<>
+	void collide< MixedBalls >( BillBall* ball1, BillBall* ball2 )
+	{
+		Vector2 const normal = normalizedVector( Vector2( ball2->getPosition().x - ball1->getPosition().x, ball2->getPosition().y - ball1->getPosition().y ) );
+		Vector2 const speed1 = ball1->getSpeed(), speed2 = ball2->getSpeed();
+		float const closing = ( speed1.x - speed2.x ) * normal.x + ( speed1.y - speed2.y ) * normal.y;
+
+		float const mass1 = ball1->getMass(), mass2 = ball2->getMass();
+		float const impulse = 2.f * mass1 * mass2 / ( mass1 + mass2 ) * closing;
+
+		ball1->setSpeed( Vector2( speed1.x - normal.x * impulse / mass1, speed1.y - normal.y * impulse / mass1 ) );
+		ball2->setSpeed( Vector2( speed2.x + normal.x * impulse / mass2, speed2.y + normal.y * impulse / mass2 ) );
+	}
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "vector2.hpp"
+#include "params.hpp"
+
+
+//-------------------------------------------------------
+//	Billiard ball
+//-------------------------------------------------------
+
+class BillBall{
+    private:
+        Vector2 position;
+        Vector2 speed = Vector2(0, 0);
+        float radius = Params::Ball::radius;
+        float mass = Params::Ball::mass;
+
+    public:
+        Vector2 getPosition() const;
+        Vector2 getSpeed() const;
+        void setPosition(Vector2 newPosition);
+        void setSpeed(Vector2 newSpeed);
+        Vector2 getNextPosition() const;
+        float getRadius() const;
+        float getMass() const;
+        void setRadius(float newRadius);
+        void setMass(float newMass);
+
+        void strike(Vector2 direction, float force);
+
+        BillBall() = default;
+        BillBall(Vector2 ballPosition);
+};
+
+
+//-------------------------------------------------------
+//	Shot of the player ball
+//-------------------------------------------------------
+
+struct Shot
+{
+	Vector2 direction;
+	float power = 0.f;		// charge progress in [ 0, 1 ]
+};
+
+
+//-------------------------------------------------------
+//	What happened to the balls during one step
+//-------------------------------------------------------
+
+struct StepEvents
+{
+	enum Kind
+	{
+		pocket = 1,
+		cushion = 2,
+		contact = 4
+	};
+
+	int pocketedMask = 0;
+	int cushionMask = 0;	// balls that bounced off a cushion
+	int contactMask = 0;	// balls that touched another ball
+	uint64_t contactPairs = 0;	// bit i * numBalls + l for every touching pair i < l
+
+	int kinds() const
+	{
+		return ( pocketedMask ? pocket : 0 ) | ( cushionMask ? cushion : 0 ) | ( contactMask ? contact : 0 );
+	}
+};
+
+
+//-------------------------------------------------------
+//	Headless table physics
+//
+//	Speeds are measured in world units per step and one
+//	step corresponds to one frame at Params::System::targetFPS.
+//	Nothing in here touches Scene, so the same code drives
+//	the rendered game, the trainer environments and any
+//	other offline simulation.
+//-------------------------------------------------------
+
+// step kinds and substepping, defined in physics_step.hpp
+namespace PhysicStep
+{
+	struct BaseStep;
+	struct NoSubsteps;
+}
+
+class PhysicTable
+{
+public:
+	static constexpr int numBalls = int( Params::Table::ballsPositions.size() );
+	static constexpr int numPockets = int( Params::Table::pocketsPositions.size() );
+
+	std::array< BillBall, numBalls > balls;
+	std::array< bool, numBalls > inGame = {};
+
+	// The standard rack is every ball of Params::Ball. The mixed one scales the radii by
+	// Params::Table::mixedRadiusScales, masses with the volume, and steps PhysicStep::Mixed.
+	enum class Rack { standard, mixed };
+	void reset( Rack rack = Rack::standard );
+
+	// strikes the player ball, returns false if it's off the table or the direction is degenerate
+	bool strike( Shot const &shot );
+
+	// advances the table by one step, returns the mask of balls pocketed during it
+	int step();
+	StepEvents stepEvents();
+
+	// Advances the table by stepSize base steps, friction summed in closed form over the
+	// step and collisions tested once at its end. A step size of 1 is exactly stepEvents().
+	// With substeps, a ball moving over Params::Physics::courantNumber radii in the step
+	// moves in substeps instead, tested against every other ball where it stands, so only
+	// the fast balls pay for the finer steps. That catches grazing contacts the base step
+	// jumps over, see tools/substep_check, and so doesn't match the game: on opening shots
+	// about 78% end with the same pocketed balls, as any two step sizes of a break do.
+	StepEvents stepEvents( float stepSize, bool substeps = false );
+	// The largest step keeping every ball within Params::Physics::courantNumber radii of the
+	// smallest ball in game, or longer when Prediction::stepsWithoutEvents rules out any
+	// event over more steps.
+	float adaptiveStepSize() const;
+
+	// The step with its physics, step kind and substepping picked at compile time, see
+	// PhysicStep::Policies; defined in physics_step.hpp. stepEvents runs PhysicStep::Standard,
+	// or PhysicStep::Mixed for tables that aren't uniform.
+	template< typename Policies, typename Substeps = PhysicStep::NoSubsteps, typename Step = PhysicStep::BaseStep >
+	StepEvents stepWith( Step step = Step() );
+
+	bool isResting() const;
+	int inGameMask() const;
+	// every ball of Params::Ball::radius and Params::Ball::mass, stepped by the uniform path
+	bool isUniform() const;
+
+private:
+	template< typename Policies >
+	void substepBall( int i, float stepSize, int substeps, StepEvents &events );
+};
+
+
+//-------------------------------------------------------
+//	physical calculations
+//-------------------------------------------------------
+
+namespace PhysicEvents
+{
+	// Which balls a collision handles, picked at compile time. Uniform balls all have
+	// Params::Ball::radius and Params::Ball::mass, so a collision just swaps the normal
+	// components of the speeds. Mixed balls read their own radius and mass and exchange
+	// the elastic impulse.
+	struct UniformBalls
+	{
+		static float radius( BillBall const& ) { return Params::Ball::radius; }
+	};
+
+	struct MixedBalls
+	{
+		static float radius( BillBall const &ball ) { return ball.getRadius(); }
+	};
+
+	Vector2 vectorProjecction(Vector2 a, Vector2 b);
+	void ricochet(BillBall* curBall);
+	template< typename Kinds = UniformBalls >
+	void collide(BillBall* ball1, BillBall* ball2);
+	template<> void collide< UniformBalls >(BillBall* ball1, BillBall* ball2);
+	template<> void collide< MixedBalls >(BillBall* ball1, BillBall* ball2);
+}
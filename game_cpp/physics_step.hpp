@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#include "physics.hpp"
+#include "prediction.hpp"
+
+
+//-------------------------------------------------------
+//	Table step built from policies
+//
+//	PhysicTable::stepWith< Policies, Substeps >( step ) is
+//	the one step sequence, friction, pockets, cushions and
+//	ball contacts, with every physical choice a policy type.
+//	Each combination compiles to its own kernel with the
+//	policy calls inlined and nothing decided per ball at run
+//	time; PhysicTable::stepEvents picks it once per step.
+//	A policy set is PhysicStep::Policies of:
+//
+//	Friction	nextPosition( ball, step ) and
+//				apply( ball, step ) for each step kind
+//	Restitution	bounce( ball ) off the cushions it crossed
+//	Broadphase	forEachBall( visit ), forEachAfter( i, visit )
+//				and forEachOther( i, visit ) over ball slots
+//	Balls		radius( ball ) and the PhysicEvents::collide
+//				specialisation
+//
+//	The step is BaseStep or ClosedFormStep, Substeps is
+//	NoSubsteps or CourantSubsteps.
+//-------------------------------------------------------
+
+namespace PhysicStep
+{
+	// The game's step, the one it is tuned on.
+	struct BaseStep
+	{
+		static constexpr float size = 1.f;
+	};
+
+	// size base steps taken as one, friction summed in closed form over it
+	struct ClosedFormStep
+	{
+		float size;
+	};
+
+
+	// Constant deceleration. Over h base steps the sum is taken in closed form: step k of a
+	// ball at speed s moves s - k * a, so h steps move h * s - a * h * ( h - 1 ) / 2 unless it
+	// rests first.
+	struct LinearFriction
+	{
+		static Vector2 nextPosition( BillBall const &ball, BaseStep )
+		{
+			return ball.getNextPosition();
+		}
+
+
+		static void apply( BillBall &ball, BaseStep )
+		{
+			float vx = ball.getSpeed().x;
+			float vy = ball.getSpeed().y;
+			if ( vx == 0 && vy == 0 )
+				return;
+
+			if ( ( vx * vx + vy * vy ) <= Params::Physics::frictionDeceleration * Params::Physics::frictionDeceleration * 1.1f )
+				ball.setSpeed( Vector2( 0, 0 ) );
+			else
+			{
+				Vector2 deceleration = normalizedVector( ball.getSpeed() );
+				deceleration.x = -deceleration.x * Params::Physics::frictionDeceleration;
+				deceleration.y = -deceleration.y * Params::Physics::frictionDeceleration;
+
+				ball.setSpeed( Vector2( vx + deceleration.x, vy + deceleration.y ) );
+			}
+		}
+
+
+		static Vector2 nextPosition( BillBall const &ball, ClosedFormStep step )
+		{
+			Vector2 const speed = ball.getSpeed();
+			if ( speed.x == 0.f && speed.y == 0.f )
+				return ball.getPosition();
+
+			float const magnitude = std::sqrt( speed.x * speed.x + speed.y * speed.y );
+			if ( restsWithin( ball, magnitude, step.size ) )
+				return Prediction::ballRest( ball ).position;
+
+			float const travelled = step.size * magnitude - Params::Physics::frictionDeceleration * std::max( 0.5f * step.size * ( step.size - 1.f ), 0.f );
+			Vector2 const direction = normalizedVector( speed );
+			return Vector2( ball.getPosition().x + direction.x * travelled, ball.getPosition().y + direction.y * travelled );
+		}
+
+
+		// the speed after the same steps, consistent with nextPosition
+		static void apply( BillBall &ball, ClosedFormStep step )
+		{
+			float vx = ball.getSpeed().x;
+			float vy = ball.getSpeed().y;
+			if ( vx == 0 && vy == 0 )
+				return;
+
+			if ( restsWithin( ball, std::sqrt( vx * vx + vy * vy ), step.size ) )
+				ball.setSpeed( Vector2( 0, 0 ) );
+			else
+			{
+				float const deceleration = step.size * Params::Physics::frictionDeceleration;
+				Vector2 const direction = normalizedVector( ball.getSpeed() );
+				ball.setSpeed( Vector2( vx - direction.x * deceleration, vy - direction.y * deceleration ) );
+			}
+		}
+
+	private:
+		// A ball two steps of friction faster than the step takes off can't rest within it,
+		// only the last steps of a run pay for Prediction::ballRest.
+		static bool restsWithin( BillBall const &ball, float magnitude, float stepSize )
+		{
+			float const deceleration = Params::Physics::frictionDeceleration;
+			if ( magnitude > ( stepSize + 2.f ) * deceleration )
+				return false;
+			return stepSize >= float( Prediction::ballRest( ball ).steps ) || magnitude <= stepSize * deceleration;
+		}
+	};
+
+
+	// cushions mirror the ball back, nothing lost
+	struct ElasticCushions
+	{
+		static void bounce( BillBall &ball ) { PhysicEvents::ricochet( &ball ); }
+	};
+
+
+	// every slot and every pair in slot order, for any ball count
+	struct AllPairs
+	{
+		template< typename Visit >
+		static void forEachBall( Visit &&visit )
+		{
+			for ( int i = 0; i < PhysicTable::numBalls; i++ )
+				visit( i );
+		}
+
+		template< typename Visit >
+		static void forEachAfter( int i, Visit &&visit )
+		{
+			for ( int l = i + 1; l < PhysicTable::numBalls; l++ )
+				visit( l );
+		}
+
+		template< typename Visit >
+		static void forEachOther( int i, Visit &&visit )
+		{
+			for ( int l = 0; l < PhysicTable::numBalls; l++ )
+				if ( l != i )
+					visit( l );
+		}
+	};
+
+
+	// The same order unrolled at compile time: slots arrive as std::integral_constant, so
+	// for the standard 7 balls the step is straight code over its 21 pairs.
+	template< int count >
+	struct UnrolledPairs
+	{
+		template< typename Visit >
+		static void forEachBall( Visit &&visit )
+		{
+			each< 0 >( visit, std::make_integer_sequence< int, count >() );
+		}
+
+		template< int i, typename Visit >
+		static void forEachAfter( std::integral_constant< int, i >, Visit &&visit )
+		{
+			each< i + 1 >( visit, std::make_integer_sequence< int, count - i - 1 >() );
+		}
+
+		template< typename Visit >
+		static void forEachOther( int i, Visit &&visit )
+		{
+			auto other = [ i, &visit ]( auto l )
+			{
+				if ( l != i )
+					visit( l );
+			};
+			each< 0 >( other, std::make_integer_sequence< int, count >() );
+		}
+
+	private:
+		template< int first, typename Visit, int... offsets >
+		static void each( Visit &visit, std::integer_sequence< int, offsets... > )
+		{
+			( visit( std::integral_constant< int, first + offsets >() ), ... );
+		}
+	};
+
+
+	template< typename FrictionPolicy, typename RestitutionPolicy, typename BroadphasePolicy, typename BallsPolicy >
+	struct Policies
+	{
+		using Friction = FrictionPolicy;
+		using Restitution = RestitutionPolicy;
+		using Broadphase = BroadphasePolicy;
+		using Balls = BallsPolicy;
+	};
+
+	// the game's table, bit for bit the step it was tuned on
+	using Standard = Policies< LinearFriction, ElasticCushions, UnrolledPairs< PhysicTable::numBalls >, PhysicEvents::UniformBalls >;
+	// balls of their own radius and mass
+	using Mixed = Policies< LinearFriction, ElasticCushions, AllPairs, PhysicEvents::MixedBalls >;
+
+
+	inline bool isOffTable( Vector2 position, float radius )
+	{
+		return ( position.x + radius > 0.5f * Params::Table::width ) ||
+			( position.x - radius < -0.5f * Params::Table::width ) ||
+			( position.y + radius > 0.5f * Params::Table::height ) ||
+			( position.y - radius < -0.5f * Params::Table::height );
+	}
+
+
+	inline bool isInPocket( Vector2 position )
+	{
+		for ( Vector2 const &pocket : Params::Table::pocketsPositions )
+			if ( distance( position, pocket ) < Params::Table::pocketRadius )
+				return true;
+		return false;
+	}
+
+
+	// substeps a ball of this radius needs to stay within courantNumber radii per substep, 1 if it's slow
+	inline int substepsFor( BillBall const &ball, float radius, float stepSize )
+	{
+		Vector2 const speed = ball.getSpeed();
+		float const travelled = stepSize * std::sqrt( speed.x * speed.x + speed.y * speed.y );
+		float const limit = Params::Physics::courantNumber * radius;
+		if ( travelled <= limit )
+			return 1;
+		return std::min( int( std::ceil( travelled / limit ) ), Params::Physics::maxSubsteps );
+	}
+
+
+	// every ball moves the whole step at once
+	struct NoSubsteps
+	{
+		template< typename Step >
+		static constexpr int count( BillBall const &, float, Step ) { return 1; }
+	};
+
+	// a ball moving over courantNumber radii in the step moves in substeps instead
+	struct CourantSubsteps
+	{
+		template< typename Step >
+		static int count( BillBall const &ball, float radius, Step step ) { return substepsFor( ball, radius, step.size ); }
+	};
+}
+
+
+template< typename Policies, typename Substeps, typename Step >
+StepEvents PhysicTable::stepWith( Step step )
+{
+	using Friction = typename Policies::Friction;
+	using Balls = typename Policies::Balls;
+	StepEvents events;
+
+	Policies::Broadphase::forEachBall( [ & ]( auto i )
+	{
+		if ( !inGame[ i ] )
+			return;
+
+		int const count = Substeps::count( balls[ i ], Balls::radius( balls[ i ] ), step );
+		if ( count > 1 )
+		{
+			substepBall< Policies >( i, step.size, count, events );
+			return;
+		}
+
+		BillBall* curBall = &balls[ i ];
+		Vector2 positionToMove = Friction::nextPosition( *curBall, step );
+
+		if ( PhysicStep::isInPocket( positionToMove ) )
+		{
+			inGame[ i ] = false;
+			events.pocketedMask |= 1 << i;
+			return;
+		}
+
+		Friction::apply( *curBall, step );
+
+		if ( PhysicStep::isOffTable( positionToMove, Balls::radius( *curBall ) ) )
+		{
+			curBall->setPosition( positionToMove );
+			Policies::Restitution::bounce( *curBall );
+			events.cushionMask |= 1 << i;
+			positionToMove = curBall->getPosition();
+		}
+
+		Policies::Broadphase::forEachAfter( i, [ & ]( auto l )
+		{
+			if ( inGame[ l ] && distance( positionToMove, balls[ l ].getPosition() ) <= Balls::radius( *curBall ) + Balls::radius( balls[ l ] ) )
+			{
+				// overlapping balls at rest keep passing the test, that's not a contact
+				bool const isIdle = positionToMove.x == curBall->getPosition().x && positionToMove.y == curBall->getPosition().y &&
+					curBall->getSpeed().x == 0.f && curBall->getSpeed().y == 0.f &&
+					balls[ l ].getSpeed().x == 0.f && balls[ l ].getSpeed().y == 0.f;
+
+				positionToMove = curBall->getPosition();
+				PhysicEvents::collide< Balls >( curBall, &balls[ l ] );
+				if ( !isIdle )
+				{
+					events.contactMask |= ( 1 << i ) | ( 1 << l );
+					events.contactPairs |= uint64_t( 1 ) << ( i * numBalls + l );
+				}
+			}
+		} );
+
+		curBall->setPosition( positionToMove );
+	} );
+
+	return events;
+}
+
+
+template< typename Policies >
+void PhysicTable::substepBall( int i, float stepSize, int substeps, StepEvents &events )
+{
+	using Friction = typename Policies::Friction;
+	using Balls = typename Policies::Balls;
+	BillBall &ball = balls[ i ];
+	PhysicStep::ClosedFormStep const substep = { stepSize / float( substeps ) };
+
+	for ( int k = 0; k < substeps && ( ball.getSpeed().x != 0.f || ball.getSpeed().y != 0.f ); k++ )
+	{
+		Vector2 positionToMove = Friction::nextPosition( ball, substep );
+		if ( PhysicStep::isInPocket( positionToMove ) )
+		{
+			inGame[ i ] = false;
+			events.pocketedMask |= 1 << i;
+			return;
+		}
+
+		Friction::apply( ball, substep );
+
+		if ( PhysicStep::isOffTable( positionToMove, Balls::radius( ball ) ) )
+		{
+			ball.setPosition( positionToMove );
+			Policies::Restitution::bounce( ball );
+			events.cushionMask |= 1 << i;
+			positionToMove = ball.getPosition();
+		}
+
+		// Balls before this one have moved already and the ones after haven't, each is where
+		// it stands now. Only approaching pairs collide, one already resolved this step from
+		// the other ball's side is moving apart and doesn't bounce back.
+		Policies::Broadphase::forEachOther( i, [ & ]( int l )
+		{
+			if ( !inGame[ l ] || distance( positionToMove, balls[ l ].getPosition() ) > Balls::radius( ball ) + Balls::radius( balls[ l ] ) )
+				return;
+
+			float const toOtherX = balls[ l ].getPosition().x - ball.getPosition().x;
+			float const toOtherY = balls[ l ].getPosition().y - ball.getPosition().y;
+			float const closingX = ball.getSpeed().x - balls[ l ].getSpeed().x;
+			float const closingY = ball.getSpeed().y - balls[ l ].getSpeed().y;
+			if ( toOtherX * closingX + toOtherY * closingY <= 0.f )
+				return;
+
+			positionToMove = ball.getPosition();
+			PhysicEvents::collide< Balls >( &ball, &balls[ l ] );
+			events.contactMask |= ( 1 << i ) | ( 1 << l );
+			events.contactPairs |= uint64_t( 1 ) << ( std::min( i, l ) * numBalls + std::max( i, l ) );
+		} );
+
+		ball.setPosition( positionToMove );
+	}
+}
@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "planner.hpp"
+#include "random.hpp"
+#include "screening.hpp"
+#include "shots.hpp"
+
+
+namespace
+{
+	//-------------------------------------------------------
+	//	Search tree
+	//-------------------------------------------------------
+
+	struct Node;
+
+	struct Edge
+	{
+		std::atomic< Node* > child { nullptr };
+		std::atomic< int > visits { 0 };
+		std::atomic< float > value { 0.f };	// sum of returns, minus the pending virtual losses
+	};
+
+
+	struct Node
+	{
+		Node( PhysicTable const &table, float reward, bool terminal, int depth, PocketField const* field );
+		Node( Node const& ) = delete;
+		~Node();
+
+		PhysicTable table;
+		float reward;		// of the shot that led here
+		bool terminal;		// no shot is played from here
+		int depth;
+
+		std::vector< Shot > shots;
+		std::unique_ptr< Edge[] > edges;
+		std::atomic< int > visits { 0 };
+	};
+
+
+	bool isTerminal( PhysicTable const &table )
+	{
+		return !table.inGame[ 0 ] || ( table.inGameMask() & ~1 ) == 0;
+	}
+
+
+	std::vector< Shot > candidateShots( PhysicTable const &table, int depth, PocketField const* field )
+	{
+		// Ranked pots first, unvisited edges are tried in order. The ghost ball line ignores
+		// throw and the other balls' motion, a pot whose cue ball reaches another ball first
+		// is dropped; the question ends at the first contact, so it costs a few dozen steps.
+		std::vector< Shot > shots;
+		for ( Shots::Candidate const &candidate : Shots::ghostBallCandidates( table, Params::Bot::ghostCandidates, field ) )
+			if ( Shots::firstContact( table, candidate.shot ) == candidate.ball )
+				shots.push_back( candidate.shot );
+
+		Random::Stream stream( uint32_t( Transposition::tableKey( table ) ), uint32_t( depth ), Random::Purpose::candidates );
+		auto randomShot = [ &stream ]()
+		{
+			Shot shot = Shots::randomShot( stream );
+			shot.power = Params::Bot::minPower + ( 1.f - Params::Bot::minPower ) * shot.power;
+			return shot;
+		};
+
+		// The root is built once per plan, its random part is the best of a screened pool
+		// rather than the first draws. Deeper nodes are built on every expansion and stay cheap.
+		if ( depth == 0 && int( shots.size() ) < Params::Bot::branching )
+		{
+			std::vector< Shot > pool( Params::Screening::rootPool );
+			for ( Shot &shot : pool )
+				shot = randomShot();
+
+			Screening::Report report;
+			int const slots = Params::Bot::branching - int( shots.size() );
+			for ( Screening::Result const &screened : Screening::screen( table, pool, report, slots, -std::numeric_limits< float >::infinity(), 0 ) )
+				shots.push_back( screened.shot );
+		}
+
+		while ( int( shots.size() ) < Params::Bot::branching )
+			shots.push_back( randomShot() );
+		return shots;
+	}
+
+
+	Node::Node( PhysicTable const &table, float reward, bool terminal, int depth, PocketField const* field ) :
+		table( table ),
+		reward( reward ),
+		terminal( terminal || depth >= Params::Bot::maxDepth || isTerminal( table ) ),
+		depth( depth )
+	{
+		if ( this->terminal )
+			return;
+		shots = candidateShots( table, depth, field );
+		edges.reset( new Edge[ shots.size() ] );
+	}
+
+
+	Node::~Node()
+	{
+		for ( size_t i = 0; i < shots.size(); i++ )
+			delete edges[ i ].child.load();
+	}
+
+
+	void add( std::atomic< float > &target, float value )
+	{
+		float expected = target.load( std::memory_order_relaxed );
+		while ( !target.compare_exchange_weak( expected, expected + value, std::memory_order_relaxed ) )
+			;
+	}
+
+
+	//-------------------------------------------------------
+	//	One search iteration
+	//-------------------------------------------------------
+
+	class Search
+	{
+	public:
+		Search( Transposition::Cache &cache, PocketField const* field, uint32_t seed ) : cache( cache ), field( field ), seed( seed ) {}
+
+		void iterate( Node* root, uint32_t thread, uint32_t iteration );
+
+	private:
+		int select( Node* node ) const;
+		Node* expand( Node* node, int action );
+		float rollout( Node const* leaf, Random::Stream &stream );
+
+		Transposition::Cache &cache;
+		PocketField const* field;
+		uint32_t seed;
+		std::vector< Edge* > path;
+	};
+
+
+	int Search::select( Node* node ) const
+	{
+		float const logVisits = std::log( float( node->visits.load( std::memory_order_relaxed ) ) + 1.f );
+
+		int best = 0;
+		float bestScore = -std::numeric_limits< float >::infinity();
+		for ( size_t i = 0; i < node->shots.size(); i++ )
+		{
+			Edge const &edge = node->edges[ i ];
+			int const visits = edge.visits.load( std::memory_order_relaxed );
+			if ( visits == 0 )
+				return int( i );
+
+			float const mean = edge.value.load( std::memory_order_relaxed ) / visits;
+			float const score = mean + Params::Bot::exploration * std::sqrt( logVisits / visits );
+			if ( score > bestScore )
+			{
+				bestScore = score;
+				best = int( i );
+			}
+		}
+		return best;
+	}
+
+
+	Node* Search::expand( Node* node, int action )
+	{
+		Shots::Outcome const outcome = Transposition::play( cache, node->table, node->shots[ action ] );
+		Node* child = new Node( outcome.table, Shots::reward( outcome.pocketedMask ), !outcome.settled, node->depth + 1, field );
+
+		Node* expected = nullptr;
+		if ( node->edges[ action ].child.compare_exchange_strong( expected, child ) )
+			return child;
+
+		// another thread published this child first
+		delete child;
+		return expected;
+	}
+
+
+	float Search::rollout( Node const* leaf, Random::Stream &stream )
+	{
+		// the sequence horizon doesn't stop rollouts, a cut off shot or the end of the game does
+		if ( leaf->terminal && ( leaf->depth < Params::Bot::maxDepth || !leaf->table.isResting() ) )
+			return 0.f;
+
+		PhysicTable table = leaf->table;
+		float result = 0.f;
+		float weight = 1.f;
+		for ( int i = 0; i < Params::Bot::rolloutShots && !isTerminal( table ); i++ )
+		{
+			Shot shot = Shots::randomShot( stream );
+			shot.power = Params::Bot::minPower + ( 1.f - Params::Bot::minPower ) * shot.power;
+
+			Shots::Outcome const outcome = Transposition::play( cache, table, shot );
+			if ( !outcome.settled )
+				break;
+			result += weight * Shots::reward( outcome.pocketedMask );
+			weight *= Params::Bot::discount;
+			table = outcome.table;
+		}
+		return result;
+	}
+
+
+	void Search::iterate( Node* root, uint32_t thread, uint32_t iteration )
+	{
+		path.clear();
+
+		// descend with virtual losses until a new leaf or the end of the sequence
+		Node* node = root;
+		while ( !node->terminal )
+		{
+			int const action = select( node );
+			Edge &edge = node->edges[ action ];
+			node->visits.fetch_add( 1, std::memory_order_relaxed );
+			edge.visits.fetch_add( 1, std::memory_order_relaxed );
+			add( edge.value, -Params::Bot::virtualLoss );
+			path.push_back( &edge );
+
+			Node* child = edge.child.load( std::memory_order_acquire );
+			if ( !child )
+			{
+				node = expand( node, action );
+				break;
+			}
+			node = child;
+		}
+
+		Random::Stream stream( thread, iteration, Random::Purpose::rollout, seed );
+		float value = rollout( node, stream );
+
+		// back the discounted return up, replacing the virtual losses
+		for ( auto edge = path.rbegin(); edge != path.rend(); ++edge )
+		{
+			Node const* child = ( *edge )->child.load( std::memory_order_acquire );
+			value = child->reward + Params::Bot::discount * value;
+			add( ( *edge )->value, value + Params::Bot::virtualLoss );
+		}
+	}
+}
+
+
+//-------------------------------------------------------
+//	Planner
+//-------------------------------------------------------
+
+Planner::Result Planner::plan( PhysicTable const &table, Clock::time_point deadline, int threads, uint32_t seed )
+{
+	Result result;
+	Node root( table, 0.f, false, 0, field );
+	if ( root.terminal )
+		return result;
+
+	if ( threads <= 0 )
+		threads = int( std::max( std::thread::hardware_concurrency(), 1u ) );
+
+	std::atomic< int > iterations { 0 };
+	auto work = [ & ]( uint32_t thread )
+	{
+		Search search( cache, field, seed );
+		while ( Clock::now() < deadline )
+			search.iterate( &root, thread, uint32_t( iterations.fetch_add( 1, std::memory_order_relaxed ) ) );
+	};
+
+	std::vector< std::thread > workers;
+	for ( int i = 1; i < threads; i++ )
+		workers.emplace_back( work, uint32_t( i ) );
+	work( 0 );
+	for ( std::thread &worker : workers )
+		worker.join();
+
+	result.shot = root.shots[ 0 ];
+	result.iterations = iterations.load();
+	for ( size_t i = 0; i < root.shots.size(); i++ )
+	{
+		Edge const &edge = root.edges[ i ];
+		int const visits = edge.visits.load();
+		float const value = visits ? edge.value.load() / visits : 0.f;
+		if ( visits > result.visits || ( visits == result.visits && visits > 0 && value > result.value ) )
+		{
+			result.shot = root.shots[ i ];
+			result.value = value;
+			result.visits = visits;
+			result.found = true;
+		}
+	}
+	return result;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "physics.hpp"
+#include "pocketability.hpp"
+#include "transposition.hpp"
+
+
+//-------------------------------------------------------
+//	Monte Carlo tree search shot planner
+//
+//	The tree expands sequences of up to Params::Bot::maxDepth
+//	shots of the same player, scored with Shots::reward and
+//	discounted, so a shot that leaves a good next one wins
+//	over a lucky pot that leaves nothing. Every node offers a
+//	fixed set of candidate shots, the ghost ball pots first
+//	and random shots after them; at the root the random ones
+//	are the best of a pool run through Screening::screen. A
+//	new leaf is valued by a few random rollout shots played
+//	on its own copy of the table.
+//
+//	Threads share one tree. Edge statistics are atomics and
+//	children are published with a compare exchange, so the
+//	search takes no locks; a virtual loss on the edges being
+//	descended keeps threads from piling onto the same line.
+//	Shot outcomes go through a Transposition::Cache that the
+//	planner keeps between calls.
+//
+//	The search is anytime: plan runs until the deadline and
+//	returns the most visited root shot found so far.
+//-------------------------------------------------------
+
+class Planner
+{
+public:
+	using Clock = std::chrono::steady_clock;
+
+	struct Result
+	{
+		Shot shot;
+		float value = 0.f;		// mean discounted return of the shot
+		int visits = 0;
+		int iterations = 0;
+		bool found = false;		// false if the deadline passed before any shot was tried
+	};
+
+	Planner() = default;
+	Planner( Planner const& ) = delete;
+
+	// plans the shot of the player ball on a resting table
+	Result plan( PhysicTable const &table, Clock::time_point deadline, int threads = Params::Bot::threads, uint32_t seed = 0 );
+
+	// lets the candidate generator rank down likely scratches, see Shots::ghostBallCandidates
+	void setPocketField( PocketField const* pocketField ) { field = pocketField; }
+
+private:
+	Transposition::Cache cache;
+	PocketField const* field = nullptr;
+};
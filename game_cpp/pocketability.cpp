@@ -0,0 +1,212 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include "hashing.hpp"
+#include "pocketability.hpp"
+
+
+namespace
+{
+	constexpr float twoPi = 6.28318531f;
+
+	// Everything the field depends on, written ahead of the masks. The version changes with
+	// the file layout or the way the field is built, the hash with any of the params after it.
+	struct FileHeader
+	{
+		char magic[ 4 ] = { 'P', 'K', 'T', 'F' };
+		uint32_t version = 2;
+		uint64_t paramsHash = 0;
+		uint32_t columns = 0;
+		uint32_t rows = 0;
+		uint32_t pockets = PocketField::numPockets;
+		uint32_t angleBins = PocketField::angleBins;
+		float cellSize = Params::Pocketability::cellSize;
+		float width = Params::Table::width;
+		float height = Params::Table::height;
+		float pocketRadius = Params::Table::pocketRadius;
+		float pocketsPositions[ 2 * PocketField::numPockets ] = {};
+	};
+	static_assert( sizeof( FileHeader ) == offsetof( FileHeader, pocketsPositions ) + sizeof( FileHeader::pocketsPositions ), "no padding, headers compare bytewise" );
+
+
+	FileHeader currentHeader( int columns, int rows )
+	{
+		FileHeader header;
+		header.columns = uint32_t( columns );
+		header.rows = uint32_t( rows );
+		for ( int i = 0; i < PocketField::numPockets; i++ )
+		{
+			header.pocketsPositions[ 2 * i ] = Params::Table::pocketsPositions[ i ].x;
+			header.pocketsPositions[ 2 * i + 1 ] = Params::Table::pocketsPositions[ i ].y;
+		}
+
+		// every 32 bit word from columns on, chained through the mixer
+		static_assert( ( sizeof( FileHeader ) - offsetof( FileHeader, columns ) ) % sizeof( uint32_t ) == 0, "the params are whole words" );
+		unsigned char const* const params = reinterpret_cast< unsigned char const* >( &header ) + offsetof( FileHeader, columns );
+		for ( size_t offset = 0; offset < sizeof( FileHeader ) - offsetof( FileHeader, columns ); offset += sizeof( uint32_t ) )
+		{
+			uint32_t word;
+			std::memcpy( &word, params + offset, sizeof( word ) );
+			header.paramsHash = Hashing::mix( header.paramsHash ^ word );
+		}
+		return header;
+	}
+
+
+	// distance along the ray to the pocket circle, negative if the ray misses it
+	float distanceToPocket( Vector2 start, Vector2 direction, Vector2 pocket )
+	{
+		float const toX = pocket.x - start.x, toY = pocket.y - start.y;
+		float const along = toX * direction.x + toY * direction.y;
+		float const offsetSquared = toX * toX + toY * toY - along * along;
+		float const radiusSquared = Params::Table::pocketRadius * Params::Table::pocketRadius;
+		if ( toX * toX + toY * toY < radiusSquared )
+			return 0.f;
+		if ( along < 0.f || offsetSquared >= radiusSquared )
+			return -1.f;
+		return along - std::sqrt( radiusSquared - offsetSquared );
+	}
+
+
+	float distanceToEdge( Vector2 start, Vector2 direction )
+	{
+		float const halfWidth = 0.5f * Params::Table::width, halfHeight = 0.5f * Params::Table::height;
+		float result = 1e30f;
+		if ( direction.x > 0.f )
+			result = std::min( result, ( halfWidth - start.x ) / direction.x );
+		if ( direction.x < 0.f )
+			result = std::min( result, ( -halfWidth - start.x ) / direction.x );
+		if ( direction.y > 0.f )
+			result = std::min( result, ( halfHeight - start.y ) / direction.y );
+		if ( direction.y < 0.f )
+			result = std::min( result, ( -halfHeight - start.y ) / direction.y );
+		return std::max( result, 0.f );
+	}
+}
+
+
+PocketField::PocketField() :
+	columns( int( std::ceil( Params::Table::width / Params::Pocketability::cellSize ) ) ),
+	rows( int( std::ceil( Params::Table::height / Params::Pocketability::cellSize ) ) )
+{
+}
+
+
+void PocketField::init( char const* path, int threads )
+{
+	if ( load( path ) )
+		return;
+	build( threads );
+	save( path );
+}
+
+
+PocketField::AngleMask PocketField::computeCell( int column, int row, int pocket ) const
+{
+	Vector2 const start( -0.5f * Params::Table::width + ( column + 0.5f ) * Params::Pocketability::cellSize,
+		-0.5f * Params::Table::height + ( row + 0.5f ) * Params::Pocketability::cellSize );
+
+	AngleMask mask = {};
+	for ( int bin = 0; bin < angleBins; bin++ )
+	{
+		float const angle = ( bin + 0.5f ) * twoPi / angleBins;
+		Vector2 const direction( std::cos( angle ), std::sin( angle ) );
+		float const toPocket = distanceToPocket( start, direction, Params::Table::pocketsPositions[ pocket ] );
+		if ( toPocket >= 0.f && toPocket <= distanceToEdge( start, direction ) )
+			mask[ bin / 64 ] |= uint64_t( 1 ) << ( bin % 64 );
+	}
+	return mask;
+}
+
+
+void PocketField::build( int threads )
+{
+	if ( threads <= 0 )
+		threads = int( std::max( std::thread::hardware_concurrency(), 1u ) );
+	threads = std::min( threads, rows );
+
+	masks.assign( size_t( columns ) * rows * numPockets, AngleMask {} );
+
+	// rows are dealt round robin, every cell is written by exactly one thread
+	auto work = [ this, threads ]( int first )
+	{
+		for ( int row = first; row < rows; row += threads )
+			for ( int column = 0; column < columns; column++ )
+				for ( int pocket = 0; pocket < numPockets; pocket++ )
+					masks[ ( size_t( row ) * columns + column ) * numPockets + pocket ] = computeCell( column, row, pocket );
+	};
+
+	std::vector< std::thread > workers;
+	for ( int i = 1; i < threads; i++ )
+		workers.emplace_back( work, i );
+	work( 0 );
+	for ( std::thread &worker : workers )
+		worker.join();
+}
+
+
+bool PocketField::load( char const* path )
+{
+	std::ifstream file( path, std::ios::binary );
+	if ( !file )
+		return false;
+
+	FileHeader const expected = currentHeader( columns, rows );
+	FileHeader header;
+	if ( !file.read( reinterpret_cast< char* >( &header ), sizeof( header ) ) || std::memcmp( &header, &expected, sizeof( header ) ) != 0 )
+		return false;
+
+	std::vector< AngleMask > loaded( size_t( columns ) * rows * numPockets );
+	if ( !file.read( reinterpret_cast< char* >( loaded.data() ), std::streamsize( loaded.size() * sizeof( AngleMask ) ) ) )
+		return false;
+
+	masks.swap( loaded );
+	return true;
+}
+
+
+bool PocketField::save( char const* path ) const
+{
+	std::ofstream file( path, std::ios::binary | std::ios::trunc );
+	if ( !file )
+		return false;
+
+	FileHeader const header = currentHeader( columns, rows );
+	file.write( reinterpret_cast< char const* >( &header ), sizeof( header ) );
+	file.write( reinterpret_cast< char const* >( masks.data() ), std::streamsize( masks.size() * sizeof( AngleMask ) ) );
+	return bool( file );
+}
+
+
+int PocketField::cellIndex( Vector2 position ) const
+{
+	int const column = std::max( std::min( int( std::floor( ( position.x + 0.5f * Params::Table::width ) / Params::Pocketability::cellSize ) ), columns - 1 ), 0 );
+	int const row = std::max( std::min( int( std::floor( ( position.y + 0.5f * Params::Table::height ) / Params::Pocketability::cellSize ) ), rows - 1 ), 0 );
+	return row * columns + column;
+}
+
+
+PocketField::AngleMask const& PocketField::angles( Vector2 position, int pocket ) const
+{
+	return masks[ size_t( cellIndex( position ) ) * numPockets + pocket ];
+}
+
+
+bool PocketField::reaches( Vector2 position, int pocket, Vector2 direction ) const
+{
+	int const bin = angleBin( direction );
+	return ( angles( position, pocket )[ bin / 64 ] >> ( bin % 64 ) ) & 1;
+}
+
+
+int PocketField::angleBin( Vector2 direction )
+{
+	float angle = std::atan2( direction.y, direction.x );
+	if ( angle < 0.f )
+		angle += twoPi;
+	return std::min( int( angle / twoPi * angleBins ), angleBins - 1 );
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "params.hpp"
+
+
+//-------------------------------------------------------
+//	Pocketability field
+//
+//	For every cell of a grid over the table and every pocket,
+//	the set of aim angles that take a ball from the cell
+//	centre into the pocket in a straight line, before it
+//	crosses the edge of the table. The physics tests a ball's
+//	next position before bouncing it, so a ball can reach a
+//	corner pocket past the cushion line, and the rail here is
+//	the table edge rather than that line.
+//
+//	The field only depends on Params::Table, so it's built
+//	once, in parallel, and cached in a file whose header
+//	records the layout it was built for, a format version
+//	and a hash of the params; a stale or missing file is
+//	rebuilt.
+//-------------------------------------------------------
+
+class PocketField
+{
+public:
+	static constexpr int numPockets = int( Params::Table::pocketsPositions.size() );
+	static constexpr int angleBins = Params::Pocketability::angleBins;
+	using AngleMask = std::array< uint64_t, ( angleBins + 63 ) / 64 >;
+
+	PocketField();
+
+	// loads the cache file or builds the field and writes it
+	void init( char const* path = Params::Pocketability::cacheFile, int threads = 0 );
+
+	void build( int threads = 0 );
+	bool load( char const* path );
+	bool save( char const* path ) const;
+
+	bool isBuilt() const { return !masks.empty(); }
+
+	AngleMask const& angles( Vector2 position, int pocket ) const;
+	bool reaches( Vector2 position, int pocket, Vector2 direction ) const;
+
+	static int angleBin( Vector2 direction );
+
+	int const columns;
+	int const rows;
+
+private:
+	int cellIndex( Vector2 position ) const;
+	AngleMask computeCell( int column, int row, int pocket ) const;
+
+	std::vector< AngleMask > masks;		// [ ( row * columns + column ) * numPockets + pocket ]
+};
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "prediction.hpp"
+
+
+namespace Prediction
+{
+	namespace
+	{
+		float speedOf( BillBall const &ball )
+		{
+			Vector2 const speed = ball.getSpeed();
+			return std::sqrt( speed.x * speed.x + speed.y * speed.y );
+		}
+
+
+		// whole steps before a ball with this speed bound can cover the gap, the test
+		// of step k looks at the position after k + 1 moves
+		int freeSteps( float gap, float speed )
+		{
+			if ( speed <= 0.f )
+				return INT_MAX;
+			if ( gap <= 0.f )
+				return 0;
+			double const steps = std::ceil( double( gap ) / speed ) - 1.0;
+			return int( std::min( std::max( steps, 0.0 ), double( INT_MAX ) ) );
+		}
+	}
+
+
+	Rest ballRest( BillBall const &ball )
+	{
+		Rest rest;
+		rest.position = ball.getPosition();
+
+		float const speed = speedOf( ball );
+		if ( speed == 0.f )
+			return rest;
+
+		// last moving step K is the first with s0 - K * a under the threshold, it still moves
+		double const deceleration = Params::Physics::frictionDeceleration;
+		double const threshold = deceleration * std::sqrt( 1.1 );
+		double const last = std::max( std::ceil( ( speed - threshold ) / deceleration ), 0.0 );
+
+		rest.steps = int( last ) + 1;
+		rest.distance = float( ( last + 1.0 ) * speed - deceleration * last * ( last + 1.0 ) / 2.0 );
+
+		Vector2 const direction = normalizedVector( ball.getSpeed() );
+		rest.position.x += direction.x * rest.distance;
+		rest.position.y += direction.y * rest.distance;
+		return rest;
+	}
+
+
+	int stepsToRest( PhysicTable const &table )
+	{
+		int steps = 0;
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+			if ( table.inGame[ i ] )
+				steps = std::max( steps, ballRest( table.balls[ i ] ).steps );
+		return steps;
+	}
+
+
+	int stepsWithoutEvents( PhysicTable const &table )
+	{
+		int steps = INT_MAX;
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		{
+			if ( !table.inGame[ i ] )
+				continue;
+
+			Vector2 const position = table.balls[ i ].getPosition();
+			float const radius = table.balls[ i ].getRadius();
+			float const speed = speedOf( table.balls[ i ] );
+			if ( speed > 0.f )
+			{
+				float const halfWidth = 0.5f * Params::Table::width - radius;
+				float const halfHeight = 0.5f * Params::Table::height - radius;
+				float const cushionGap = std::min( halfWidth - std::abs( position.x ), halfHeight - std::abs( position.y ) );
+				steps = std::min( steps, freeSteps( cushionGap, speed ) );
+
+				for ( Vector2 const &pocket : Params::Table::pocketsPositions )
+					steps = std::min( steps, freeSteps( distance( position, pocket ) - Params::Table::pocketRadius, speed ) );
+			}
+
+			for ( int l = i + 1; l < PhysicTable::numBalls; l++ )
+			{
+				if ( !table.inGame[ l ] )
+					continue;
+				// two balls at rest never make a contact, even overlapping
+				float const gap = distance( position, table.balls[ l ].getPosition() ) - ( radius + table.balls[ l ].getRadius() );
+				steps = std::min( steps, freeSteps( gap, speed + speedOf( table.balls[ l ] ) ) );
+			}
+		}
+
+		// capped at the rest, where the shot ends
+		return std::min( steps, stepsToRest( table ) );
+	}
+}
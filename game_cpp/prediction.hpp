@@ -0,0 +1,38 @@
+#pragma once
+
+#include "physics.hpp"
+
+
+//-------------------------------------------------------
+//	Closed form motion of free balls
+//
+//	Between contacts a ball moves along a line and friction
+//	takes frictionDeceleration off its speed every step, so
+//	with s0 the speed at strike and a the deceleration it
+//	moves s0 - k * a on step k until the speed drops under
+//	the stop threshold a * sqrt( 1.1 ). These sums predict
+//	when and where it rests; the real step normalises the
+//	speed every step, so float rounding can move the stop
+//	by one step in rare cases.
+//-------------------------------------------------------
+
+namespace Prediction
+{
+	struct Rest
+	{
+		int steps = 0;			// until the speed is zero
+		float distance = 0.f;
+		Vector2 position;
+	};
+
+	// assuming no contacts, pockets or cushions on the way
+	Rest ballRest( BillBall const &ball );
+
+	// the longest ballRest of the balls in game
+	int stepsToRest( PhysicTable const &table );
+
+	// Lower bound on the steps that can run before any pocket, cushion or ball contact
+	// happens, from each ball's speed bound. Steps below it are pure friction and can
+	// go without collision tests, PhysicTable::adaptiveStepSize takes them as one step.
+	int stepsWithoutEvents( PhysicTable const &table );
+}
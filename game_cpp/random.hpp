@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include "vector2.hpp"
+
+
+//-------------------------------------------------------
+//	Counter based random numbers ( Philox4x32-10 )
+//
+//	Every number is a pure function of a key and a counter,
+//	so there is no generator state to share between threads:
+//	the key names the table and the seed, the counter names
+//	the shot, what the numbers are for and the draw index.
+//	The same ( table, shot ) pair gives the same numbers no
+//	matter which thread or in which order asks for them.
+//-------------------------------------------------------
+
+namespace Random
+{
+	using Counter = std::array< uint32_t, 4 >;
+	using Key = std::array< uint32_t, 2 >;
+
+
+	inline void mulhilo( uint32_t a, uint32_t b, uint32_t &hi, uint32_t &lo )
+	{
+		uint64_t const product = uint64_t( a ) * uint64_t( b );
+		hi = uint32_t( product >> 32 );
+		lo = uint32_t( product );
+	}
+
+
+	inline Counter philox( Counter counter, Key key )
+	{
+		constexpr uint32_t multiplier0 = 0xD2511F53;
+		constexpr uint32_t multiplier1 = 0xCD9E8D57;
+		constexpr uint32_t weyl0 = 0x9E3779B9;
+		constexpr uint32_t weyl1 = 0xBB67AE85;
+
+		for ( int round = 0; round < 10; round++ )
+		{
+			uint32_t hi0, lo0, hi1, lo1;
+			mulhilo( multiplier0, counter[ 0 ], hi0, lo0 );
+			mulhilo( multiplier1, counter[ 2 ], hi1, lo1 );
+			counter = { hi1 ^ counter[ 1 ] ^ key[ 0 ], lo1, hi0 ^ counter[ 3 ] ^ key[ 1 ], lo0 };
+			key[ 0 ] += weyl0;
+			key[ 1 ] += weyl1;
+		}
+		return counter;
+	}
+
+
+	// uniform in [ 0, 1 ) from the top 24 bits
+	inline float toUniform( uint32_t bits )
+	{
+		return float( bits >> 8 ) * ( 1.f / 16777216.f );
+	}
+
+
+	enum class Purpose : uint32_t
+	{
+		rack = 1,
+		shot = 2,
+		noise = 3,
+		candidates = 4,
+		rollout = 5,
+		stress = 6
+	};
+
+
+	// numbers for one ( table, shot, purpose ), the only state is the local draw index
+	class Stream
+	{
+	public:
+		Stream( uint32_t tableId, uint32_t shotIndex, Purpose purpose, uint32_t seed = 0 );
+
+		uint32_t nextBits();
+		float uniform();
+		float uniform( float low, float high );
+		float normal();
+
+	private:
+		Key key;
+		Counter counter;
+		Counter block = {};
+		int used = 4;
+	};
+
+
+	inline Stream::Stream( uint32_t tableId, uint32_t shotIndex, Purpose purpose, uint32_t seed ) :
+		key{ tableId, seed },
+		counter{ shotIndex, uint32_t( purpose ), 0, 0 }
+	{
+	}
+
+
+	inline uint32_t Stream::nextBits()
+	{
+		if ( used == 4 )
+		{
+			block = philox( counter, key );
+			counter[ 2 ]++;
+			used = 0;
+		}
+		return block[ used++ ];
+	}
+
+
+	inline float Stream::uniform()
+	{
+		return toUniform( nextBits() );
+	}
+
+
+	inline float Stream::uniform( float low, float high )
+	{
+		return low + ( high - low ) * uniform();
+	}
+
+
+	// Box-Muller, one of the pair is dropped to keep draws independent of call order
+	inline float Stream::normal()
+	{
+		constexpr float twoPi = 6.28318531f;
+		float const u1 = 1.f - uniform();
+		float const u2 = uniform();
+		return std::sqrt( -2.f * std::log( u1 ) ) * std::cos( twoPi * u2 );
+	}
+
+
+	// stateless bulk fill, the loop has no carried state so it vectorizes
+	inline void fillUniform( Key key, uint32_t shotIndex, Purpose purpose, float* values, int count )
+	{
+		for ( int n = 0; n < count; n += 4 )
+		{
+			Counter const bits = philox( { shotIndex, uint32_t( purpose ), uint32_t( n / 4 ), 0 }, key );
+			for ( int k = 0; k < 4 && n + k < count; k++ )
+				values[ n + k ] = toUniform( bits[ k ] );
+		}
+	}
+}
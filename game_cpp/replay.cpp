@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <cstring>
+
+#include "replay.hpp"
+
+
+namespace Replay
+{
+	namespace
+	{
+		// file: header, records, index entries, footer
+		struct FileHeader
+		{
+			char magic[ 4 ] = { 'B', 'R', 'P', 'L' };
+			uint32_t version = 2;
+			uint32_t numBalls = PhysicTable::numBalls;
+			uint32_t keyframeInterval = Params::Replay::keyframeInterval;
+		};
+
+		struct Footer
+		{
+			uint64_t indexOffset = 0;
+			uint32_t indexCount = 0;
+			uint32_t lastFrame = 0;
+			char magic[ 4 ] = { 'B', 'I', 'D', 'X' };
+			uint32_t padding = 0;
+		};
+
+		enum class RecordKind : uint32_t
+		{
+			keyframe = 1,
+			strike = 2
+		};
+
+		struct RecordHeader
+		{
+			RecordKind kind;
+			uint32_t frame;
+		};
+
+		struct KeyframeRecord
+		{
+			float state[ PhysicTable::numBalls ][ 4 ];		// position and speed
+			float sizes[ PhysicTable::numBalls ][ 2 ];		// radius and mass, the rack may mix them
+			uint32_t inGameMask;
+		};
+
+		struct StrikeRecord
+		{
+			float directionX;
+			float directionY;
+			float power;
+		};
+
+
+		template< typename Record >
+		void writeRecord( std::ofstream &file, Record const &record )
+		{
+			file.write( reinterpret_cast< char const* >( &record ), sizeof( record ) );
+		}
+
+
+		template< typename Record >
+		bool readRecord( std::ifstream &file, Record &record )
+		{
+			return bool( file.read( reinterpret_cast< char* >( &record ), sizeof( record ) ) );
+		}
+
+
+		KeyframeRecord pack( PhysicTable const &table )
+		{
+			KeyframeRecord record;
+			for ( int i = 0; i < PhysicTable::numBalls; i++ )
+			{
+				record.state[ i ][ 0 ] = table.balls[ i ].getPosition().x;
+				record.state[ i ][ 1 ] = table.balls[ i ].getPosition().y;
+				record.state[ i ][ 2 ] = table.balls[ i ].getSpeed().x;
+				record.state[ i ][ 3 ] = table.balls[ i ].getSpeed().y;
+				record.sizes[ i ][ 0 ] = table.balls[ i ].getRadius();
+				record.sizes[ i ][ 1 ] = table.balls[ i ].getMass();
+			}
+			record.inGameMask = uint32_t( table.inGameMask() );
+			return record;
+		}
+
+
+		void unpack( KeyframeRecord const &record, PhysicTable &table )
+		{
+			for ( int i = 0; i < PhysicTable::numBalls; i++ )
+			{
+				table.balls[ i ].setPosition( Vector2( record.state[ i ][ 0 ], record.state[ i ][ 1 ] ) );
+				table.balls[ i ].setSpeed( Vector2( record.state[ i ][ 2 ], record.state[ i ][ 3 ] ) );
+				table.balls[ i ].setRadius( record.sizes[ i ][ 0 ] );
+				table.balls[ i ].setMass( record.sizes[ i ][ 1 ] );
+				table.inGame[ i ] = ( record.inGameMask & ( 1u << i ) ) != 0;
+			}
+		}
+
+
+		size_t payloadSize( RecordKind kind )
+		{
+			switch ( kind )
+			{
+				case RecordKind::keyframe: return sizeof( KeyframeRecord );
+				case RecordKind::strike: return sizeof( StrikeRecord );
+			}
+			return 0;
+		}
+	}
+
+
+	//-------------------------------------------------------
+	//	Writer
+	//-------------------------------------------------------
+
+	Writer::~Writer()
+	{
+		close();
+	}
+
+
+	bool Writer::open( char const* path )
+	{
+		close();
+		file.open( path, std::ios::binary | std::ios::trunc );
+		if ( !file )
+			return false;
+
+		writeRecord( file, FileHeader() );
+		index.clear();
+		frame = 0;
+		started = false;
+		return true;
+	}
+
+
+	void Writer::close()
+	{
+		if ( !file.is_open() )
+			return;
+
+		Footer footer;
+		footer.indexOffset = uint64_t( file.tellp() );
+		footer.indexCount = uint32_t( index.size() );
+		footer.lastFrame = frame;
+		for ( IndexEntry const &entry : index )
+		{
+			writeRecord( file, entry.frame );
+			writeRecord( file, entry.offset );
+		}
+		writeRecord( file, footer );
+		file.close();
+	}
+
+
+	void Writer::keyframe( PhysicTable const &table )
+	{
+		index.push_back( { frame, uint64_t( file.tellp() ) } );
+		writeRecord( file, RecordHeader { RecordKind::keyframe, frame } );
+		writeRecord( file, pack( table ) );
+	}
+
+
+	void Writer::reset( PhysicTable const &table )
+	{
+		if ( !file.is_open() )
+			return;
+		keyframe( table );
+		started = true;
+	}
+
+
+	void Writer::strike( Shot const &shot )
+	{
+		if ( !file.is_open() || !started )
+			return;
+		writeRecord( file, RecordHeader { RecordKind::strike, frame } );
+		writeRecord( file, StrikeRecord { shot.direction.x, shot.direction.y, shot.power } );
+	}
+
+
+	void Writer::step( PhysicTable const &table )
+	{
+		if ( !file.is_open() || !started )
+			return;
+		frame++;
+		if ( frame % Params::Replay::keyframeInterval == 0 )
+			keyframe( table );
+	}
+
+
+	//-------------------------------------------------------
+	//	Reader
+	//-------------------------------------------------------
+
+	bool Reader::open( char const* path )
+	{
+		file.close();
+		file.clear();
+		index.clear();
+		file.open( path, std::ios::binary );
+		if ( !file )
+			return false;
+
+		FileHeader header;
+		FileHeader const expected;
+		if ( !readRecord( file, header ) || std::memcmp( &header, &expected, sizeof( header ) ) != 0 )
+			return false;
+
+		complete = readIndex();
+		return complete || scanIndex();
+	}
+
+
+	bool Reader::readIndex()
+	{
+		file.clear();
+		file.seekg( 0, std::ios::end );
+		std::streamoff const size = file.tellg();
+		if ( size < std::streamoff( sizeof( FileHeader ) + sizeof( Footer ) ) )
+			return false;
+
+		Footer footer;
+		Footer const expected;
+		file.seekg( size - std::streamoff( sizeof( Footer ) ) );
+		if ( !readRecord( file, footer ) || std::memcmp( footer.magic, expected.magic, sizeof( footer.magic ) ) != 0 )
+			return false;
+
+		uint64_t const entrySize = sizeof( uint32_t ) + sizeof( uint64_t );
+		if ( footer.indexOffset + footer.indexCount * entrySize + sizeof( Footer ) != uint64_t( size ) )
+			return false;
+
+		file.seekg( std::streamoff( footer.indexOffset ) );
+		index.resize( footer.indexCount );
+		for ( IndexEntry &entry : index )
+			if ( !readRecord( file, entry.frame ) || !readRecord( file, entry.offset ) )
+				return false;
+
+		recordsEnd = footer.indexOffset;
+		lastFrame = footer.lastFrame;
+		return !index.empty();
+	}
+
+
+	bool Reader::scanIndex()
+	{
+		index.clear();
+		lastFrame = 0;
+
+		file.clear();
+		file.seekg( sizeof( FileHeader ) );
+
+		// stops at the first record cut short or not a record at all
+		std::vector< char > payload;
+		uint64_t offset = sizeof( FileHeader );
+		RecordHeader record;
+		while ( readRecord( file, record ) )
+		{
+			size_t const size = payloadSize( record.kind );
+			payload.resize( size );
+			if ( size == 0 || !file.read( payload.data(), std::streamsize( size ) ) )
+				break;
+
+			if ( record.kind == RecordKind::keyframe )
+				index.push_back( { record.frame, offset } );
+			lastFrame = std::max( lastFrame, record.frame );
+			offset += sizeof( RecordHeader ) + size;
+			recordsEnd = offset;
+		}
+
+		// the cut may have taken more records of the last frame, only the ones before it are whole
+		if ( index.empty() || lastFrame == 0 )
+			return false;
+		lastFrame--;
+		return true;
+	}
+
+
+	bool Reader::seek( uint32_t frame, PhysicTable &table )
+	{
+		if ( index.empty() || frame < index.front().frame || frame > lastFrame )
+			return false;
+
+		// the last keyframe at or before the frame, a reset keyframe wins over the periodic one
+		auto const after = std::upper_bound( index.begin(), index.end(), frame,
+			[]( uint32_t value, IndexEntry const &entry ) { return value < entry.frame; } );
+		IndexEntry const &start = *( after - 1 );
+
+		file.clear();
+		file.seekg( std::streamoff( start.offset ) );
+
+		uint32_t current = start.frame;
+		RecordHeader record;
+		while ( uint64_t( file.tellg() ) < recordsEnd && readRecord( file, record ) && record.frame <= frame )
+		{
+			for ( ; current < record.frame; current++ )
+				table.step();
+
+			if ( record.kind == RecordKind::keyframe )
+			{
+				KeyframeRecord keyframe;
+				if ( !readRecord( file, keyframe ) )
+					return false;
+				unpack( keyframe, table );
+			}
+			else if ( record.kind == RecordKind::strike )
+			{
+				StrikeRecord strike;
+				if ( !readRecord( file, strike ) )
+					return false;
+				Shot shot;
+				shot.direction = Vector2( strike.directionX, strike.directionY );
+				shot.power = strike.power;
+				table.strike( shot );
+			}
+			else
+				return false;
+		}
+
+		for ( ; current < frame; current++ )
+			table.step();
+		return true;
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#include "physics.hpp"
+
+
+//-------------------------------------------------------
+//	Seekable replays
+//
+//	A replay is a stream of records stamped with the number of
+//	steps played so far: full table keyframes every
+//	Params::Replay::keyframeInterval steps and whenever the
+//	table is reset, and the shots struck in between. An index
+//	of the keyframes closes the file, so a reader seeks to the
+//	last keyframe before a frame and replays at most one
+//	interval of steps; a file cut short without its index is
+//	scanned once to rebuild it and holds the frames before its
+//	last whole record.
+//
+//	The state at frame F is the table after F steps and after
+//	the records stamped F.
+//-------------------------------------------------------
+
+namespace Replay
+{
+	struct IndexEntry
+	{
+		uint32_t frame;
+		uint64_t offset;
+	};
+
+
+	class Writer
+	{
+	public:
+		Writer() = default;
+		Writer( Writer const& ) = delete;
+		~Writer();
+
+		bool open( char const* path );
+		// writes the index, does nothing if not open
+		void close();
+		bool isOpen() const { return file.is_open(); }
+
+		// a new table, the first one of a recording included
+		void reset( PhysicTable const &table );
+		void strike( Shot const &shot );
+		// after every step, keyframes fall on the interval
+		void step( PhysicTable const &table );
+
+	private:
+		void keyframe( PhysicTable const &table );
+
+		std::ofstream file;
+		std::vector< IndexEntry > index;
+		uint32_t frame = 0;
+		bool started = false;
+	};
+
+
+	class Reader
+	{
+	public:
+		bool open( char const* path );
+
+		// last frame recorded
+		uint32_t frameCount() const { return lastFrame; }
+		std::vector< IndexEntry > const& keyframes() const { return index; }
+		// false for a file cut short, it ends at its last whole record
+		bool isComplete() const { return complete; }
+
+		// false past the last frame recorded or on a record cut short, the table is then undefined
+		bool seek( uint32_t frame, PhysicTable &table );
+
+	private:
+		bool readIndex();
+		bool scanIndex();
+
+		std::ifstream file;
+		std::vector< IndexEntry > index;
+		uint64_t recordsEnd = 0;
+		uint32_t lastFrame = 0;
+		bool complete = false;
+	};
+}
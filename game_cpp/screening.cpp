@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+#include "screening.hpp"
+
+
+namespace Screening
+{
+	namespace
+	{
+		constexpr int numBalls = PhysicTable::numBalls;
+
+		struct CoarseTable
+		{
+			explicit CoarseTable( PhysicTable const &table );
+			void store( PhysicTable &table ) const;
+
+			// advances stepSize base steps, returns the mask of balls pocketed
+			int step();
+			bool isResting() const;
+
+			std::array< float, numBalls > x, y, speedX, speedY;
+			// each ball's own, the planner screens the mixed rack too
+			std::array< float, numBalls > radius, mass;
+			int inGameMask;
+		};
+
+
+		CoarseTable::CoarseTable( PhysicTable const &table ) :
+			inGameMask( table.inGameMask() )
+		{
+			for ( int i = 0; i < numBalls; i++ )
+			{
+				x[ i ] = table.balls[ i ].getPosition().x;
+				y[ i ] = table.balls[ i ].getPosition().y;
+				speedX[ i ] = table.balls[ i ].getSpeed().x;
+				speedY[ i ] = table.balls[ i ].getSpeed().y;
+				radius[ i ] = table.balls[ i ].getRadius();
+				mass[ i ] = table.balls[ i ].getMass();
+			}
+		}
+
+
+		void CoarseTable::store( PhysicTable &table ) const
+		{
+			for ( int i = 0; i < numBalls; i++ )
+			{
+				table.inGame[ i ] = ( inGameMask & ( 1 << i ) ) != 0;
+				table.balls[ i ].setPosition( Vector2( x[ i ], y[ i ] ) );
+				table.balls[ i ].setSpeed( Vector2( speedX[ i ], speedY[ i ] ) );
+			}
+		}
+
+
+		bool CoarseTable::isResting() const
+		{
+			for ( int i = 0; i < numBalls; i++ )
+				if ( ( inGameMask & ( 1 << i ) ) && ( speedX[ i ] != 0.f || speedY[ i ] != 0.f ) )
+					return false;
+			return true;
+		}
+
+
+		// squared distance from a point to the segment start + t * delta, t in [ 0, 1 ]
+		float squaredDistanceToPath( float px, float py, float startX, float startY, float deltaX, float deltaY )
+		{
+			float const lengthSquared = deltaX * deltaX + deltaY * deltaY;
+			float t = lengthSquared > 0.f ? ( ( px - startX ) * deltaX + ( py - startY ) * deltaY ) / lengthSquared : 0.f;
+			t = std::max( std::min( t, 1.f ), 0.f );
+			float const ex = startX + t * deltaX - px, ey = startY + t * deltaY - py;
+			return ex * ex + ey * ey;
+		}
+
+
+		void mirror( float &position, float &speed, float limit )
+		{
+			if ( position > limit )
+			{
+				position = 2.f * limit - position;
+				speed = -speed;
+			}
+			else if ( position < -limit )
+			{
+				position = -2.f * limit - position;
+				speed = -speed;
+			}
+		}
+
+
+		int CoarseTable::step()
+		{
+			constexpr float h = float( Params::Screening::stepSize );
+			float const deceleration = Params::Physics::frictionDeceleration;
+			float const pocketSquared = Params::Table::pocketRadius * Params::Table::pocketRadius;
+
+			// travel with friction integrated over the step: h * s - a * h * ( h - 1 ) / 2, or s^2 / 2a if it stops
+			std::array< float, numBalls > deltaX = {}, deltaY = {}, travelSpeeds = {};
+			for ( int i = 0; i < numBalls; i++ )
+			{
+				if ( !( inGameMask & ( 1 << i ) ) || ( speedX[ i ] == 0.f && speedY[ i ] == 0.f ) )
+					continue;
+
+				float const speed = std::sqrt( speedX[ i ] * speedX[ i ] + speedY[ i ] * speedY[ i ] );
+				travelSpeeds[ i ] = speed;
+				float const remaining = speed - h * deceleration;
+				bool const stops = remaining * remaining <= deceleration * deceleration * 1.1f || remaining <= 0.f;
+				float const travel = stops ? 0.5f * speed * speed / deceleration + 0.5f * speed : h * speed - 0.5f * deceleration * h * ( h - 1.f );
+
+				deltaX[ i ] = speedX[ i ] / speed * travel;
+				deltaY[ i ] = speedY[ i ] / speed * travel;
+				float const scale = stops ? 0.f : remaining / speed;
+				speedX[ i ] *= scale;
+				speedY[ i ] *= scale;
+			}
+
+			// the full step only tests the positions a ball lands on, a swept test would drop balls grazing a pocket
+			int pocketedMask = 0;
+			for ( int i = 0; i < numBalls; i++ )
+			{
+				if ( !( inGameMask & ( 1 << i ) ) || ( deltaX[ i ] == 0.f && deltaY[ i ] == 0.f ) )
+					continue;
+
+				float const travel = std::sqrt( deltaX[ i ] * deltaX[ i ] + deltaY[ i ] * deltaY[ i ] );
+				float const speed = travelSpeeds[ i ];
+				float landed = 0.f;
+				for ( int j = 0; j < Params::Screening::stepSize && landed < travel && !( pocketedMask & ( 1 << i ) ); j++ )
+				{
+					landed = std::min( landed + std::max( speed - j * deceleration, 0.f ), travel );
+					float const px = x[ i ] + deltaX[ i ] * landed / travel, py = y[ i ] + deltaY[ i ] * landed / travel;
+					for ( Vector2 const &pocket : Params::Table::pocketsPositions )
+					{
+						if ( ( px - pocket.x ) * ( px - pocket.x ) + ( py - pocket.y ) * ( py - pocket.y ) < pocketSquared )
+						{
+							pocketedMask |= 1 << i;
+							break;
+						}
+					}
+				}
+			}
+			inGameMask &= ~pocketedMask;
+
+			// Swept contacts, the first touch of each pair exchanges the normal speeds by the masses
+			// and the rest of the step uses the new ones. Equal masses just swap them.
+			for ( int i = 0; i < numBalls; i++ )
+			{
+				if ( !( inGameMask & ( 1 << i ) ) )
+					continue;
+				for ( int l = i + 1; l < numBalls; l++ )
+				{
+					if ( !( inGameMask & ( 1 << l ) ) )
+						continue;
+
+					float const contact = radius[ i ] + radius[ l ];
+					float const contactSquared = contact * contact;
+					float const gapX = x[ l ] - x[ i ], gapY = y[ l ] - y[ i ];
+					float const closingX = deltaX[ l ] - deltaX[ i ], closingY = deltaY[ l ] - deltaY[ i ];
+					float const approach = gapX * closingX + gapY * closingY;
+					if ( approach >= 0.f || squaredDistanceToPath( 0.f, 0.f, gapX, gapY, closingX, closingY ) >= contactSquared )
+						continue;
+
+					// earliest touch with | gap + touch * closing | = the sum of the radii
+					float const a = closingX * closingX + closingY * closingY;
+					float const c = gapX * gapX + gapY * gapY - contactSquared;
+					float const discriminant = std::max( approach * approach - a * c, 0.f );
+					float const touch = std::max( ( -approach - std::sqrt( discriminant ) ) / a, 0.f );
+					// the full step resolves a contact from the positions of the base step before the overlap
+					float const t = std::max( std::ceil( touch * h ) - 1.f, 0.f ) / h;
+
+					float const normalX = gapX + t * closingX, normalY = gapY + t * closingY;
+					float const normalSquared = normalX * normalX + normalY * normalY;
+					if ( normalSquared == 0.f )
+						continue;
+
+					float const exchange = ( ( speedX[ i ] - speedX[ l ] ) * normalX + ( speedY[ i ] - speedY[ l ] ) * normalY ) / normalSquared;
+					float const shareI = 2.f * mass[ l ] / ( mass[ i ] + mass[ l ] ), shareL = 2.f * mass[ i ] / ( mass[ i ] + mass[ l ] );
+					speedX[ i ] -= exchange * shareI * normalX;
+					speedY[ i ] -= exchange * shareI * normalY;
+					speedX[ l ] += exchange * shareL * normalX;
+					speedY[ l ] += exchange * shareL * normalY;
+
+					// keep the travel up to the contact, the rest of the step goes at the new speeds
+					float const rest = ( 1.f - t ) * h;
+					deltaX[ i ] = t * deltaX[ i ] + rest * speedX[ i ];
+					deltaY[ i ] = t * deltaY[ i ] + rest * speedY[ i ];
+					deltaX[ l ] = t * deltaX[ l ] + rest * speedX[ l ];
+					deltaY[ l ] = t * deltaY[ l ] + rest * speedY[ l ];
+				}
+			}
+
+			for ( int i = 0; i < numBalls; i++ )
+			{
+				if ( !( inGameMask & ( 1 << i ) ) )
+					continue;
+				x[ i ] += deltaX[ i ];
+				y[ i ] += deltaY[ i ];
+				mirror( x[ i ], speedX[ i ], 0.5f * Params::Table::width - radius[ i ] );
+				mirror( y[ i ], speedY[ i ], 0.5f * Params::Table::height - radius[ i ] );
+			}
+			return pocketedMask;
+		}
+	}
+
+
+	Shots::Outcome coarsePlay( PhysicTable const &table, Shot const &shot, int maxSteps )
+	{
+		PhysicTable struck = table;
+		struck.strike( shot );
+
+		CoarseTable coarse( struck );
+		Shots::Outcome outcome;
+		while ( outcome.steps < maxSteps && !coarse.isResting() )
+		{
+			outcome.pocketedMask |= coarse.step();
+			outcome.steps += Params::Screening::stepSize;
+		}
+		outcome.settled = coarse.isResting();
+		coarse.store( outcome.table );
+		return outcome;
+	}
+
+
+	std::vector< Result > screen( PhysicTable const &table, std::vector< Shot > const &shots, Report &report, int topK, float threshold, int auditInterval )
+	{
+		std::vector< float > coarseRewards( shots.size() );
+		std::vector< int > coarseMasks( shots.size() );
+		for ( size_t i = 0; i < shots.size(); i++ )
+		{
+			Shots::Outcome const coarse = coarsePlay( table, shots[ i ] );
+			coarseMasks[ i ] = coarse.pocketedMask;
+			coarseRewards[ i ] = Shots::reward( coarse.pocketedMask );
+		}
+		report.screened += int( shots.size() );
+
+		std::vector< int > order( shots.size() );
+		std::iota( order.begin(), order.end(), 0 );
+		std::stable_sort( order.begin(), order.end(), [ & ]( int a, int b ) { return coarseRewards[ a ] > coarseRewards[ b ]; } );
+
+		std::vector< Result > results;
+		int screenedOut = 0;
+		for ( int index : order )
+		{
+			bool const verify = int( results.size() ) < topK && coarseRewards[ index ] >= threshold;
+			if ( !verify && ( auditInterval <= 0 || ++screenedOut % auditInterval != 0 ) )
+				continue;
+
+			Shots::Outcome const outcome = Shots::play( table, shots[ index ] );
+			bool const agreed = outcome.pocketedMask == coarseMasks[ index ];
+			if ( verify )
+			{
+				report.verified++;
+				report.verifiedAgreed += agreed ? 1 : 0;
+				results.push_back( { shots[ index ], coarseRewards[ index ], outcome } );
+			}
+			else
+			{
+				report.audited++;
+				report.auditedAgreed += agreed ? 1 : 0;
+			}
+		}
+
+		std::stable_sort( results.begin(), results.end(),
+			[]( Result const &a, Result const &b ) { return Shots::reward( a.outcome.pocketedMask ) > Shots::reward( b.outcome.pocketedMask ); } );
+		return results;
+	}
+}
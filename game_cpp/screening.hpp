@@ -0,0 +1,56 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "physics.hpp"
+#include "shots.hpp"
+
+
+//-------------------------------------------------------
+//	Two tier shot screening
+//
+//	The coarse simulation advances Params::Screening::stepSize
+//	steps at once: friction is integrated over the whole step,
+//	pockets and ball contacts are found by swept tests, a
+//	contact exchanges the normal speeds of the two balls by
+//	their masses and cushions are plain mirrors, all with
+//	each ball's own radius. It's a few times cheaper than
+//	the full step and agrees with it on most shots, not all.
+//
+//	screen plays every candidate coarsely, re-simulates the
+//	best ones in full and reports how often the two agreed,
+//	which is what the screening threshold is tuned on.
+//-------------------------------------------------------
+
+namespace Screening
+{
+	// the outcome table holds the coarse rest positions
+	Shots::Outcome coarsePlay( PhysicTable const &table, Shot const &shot, int maxSteps = Params::Env::maxShotSteps );
+
+	struct Result
+	{
+		Shot shot;
+		float coarseReward = 0.f;
+		Shots::Outcome outcome;		// full simulation
+	};
+
+	struct Report
+	{
+		int screened = 0;
+		int verified = 0;
+		int verifiedAgreed = 0;		// same pocketed mask in both tiers
+		int audited = 0;			// screened out shots simulated in full anyway
+		int auditedAgreed = 0;
+
+		float agreementRate() const { return verified ? float( verifiedAgreed ) / verified : 1.f; }
+		float auditAgreementRate() const { return audited ? float( auditedAgreed ) / audited : 1.f; }
+	};
+
+	// Verifies the topK shots with the best coarse reward, skipping those under threshold.
+	// Returns them sorted by their full reward, best first; the report accumulates.
+	// An audit interval of 0 simulates no screened out shot.
+	std::vector< Result > screen( PhysicTable const &table, std::vector< Shot > const &shots, Report &report,
+		int topK = Params::Screening::topK, float threshold = -std::numeric_limits< float >::infinity(),
+		int auditInterval = Params::Screening::auditInterval );
+}
@@ -0,0 +1,268 @@
+#include <algorithm>
+#include <cmath>
+
+#include "shots.hpp"
+
+
+namespace Shots
+{
+	Outcome play( PhysicTable const &table, Shot const &shot, int maxSteps )
+	{
+		return playUntil( table, shot, 0, []( PhysicTable const&, StepEvents const& ) { return false; }, maxSteps );
+	}
+
+
+	Outcome playAdaptive( PhysicTable const &table, Shot const &shot, int maxSteps )
+	{
+		Outcome outcome;
+		outcome.table = table;
+		outcome.table.strike( shot );
+
+		while ( outcome.elapsed < float( maxSteps ) && !outcome.table.isResting() )
+		{
+			float const stepSize = std::min( outcome.table.adaptiveStepSize(), float( maxSteps ) - outcome.elapsed );
+			outcome.pocketedMask |= outcome.table.stepEvents( stepSize ).pocketedMask;
+			outcome.steps++;
+			outcome.elapsed += stepSize;
+		}
+		outcome.settled = outcome.table.isResting();
+		return outcome;
+	}
+
+
+	bool isBallPocketed( PhysicTable const &table, Shot const &shot, int ball, int maxSteps )
+	{
+		int const ballBit = 1 << ball;
+		Outcome const outcome = playUntil( table, shot, StepEvents::pocket,
+			[ ballBit ]( PhysicTable const&, StepEvents const &events ) { return ( events.pocketedMask & ballBit ) != 0; }, maxSteps );
+		return ( outcome.pocketedMask & ballBit ) != 0;
+	}
+
+
+	bool isScratch( PhysicTable const &table, Shot const &shot, int maxSteps )
+	{
+		return isBallPocketed( table, shot, 0, maxSteps );
+	}
+
+
+	int firstContact( PhysicTable const &table, Shot const &shot, int maxSteps )
+	{
+		// contacts within one step aren't ordered, the lowest ball wins a tie
+		int contact = -1;
+		playUntil( table, shot, StepEvents::contact | StepEvents::pocket,
+			[ &contact ]( PhysicTable const &current, StepEvents const &events )
+			{
+				for ( int i = 1; i < PhysicTable::numBalls; i++ )
+				{
+					if ( events.contactPairs & ( uint64_t( 1 ) << i ) )
+					{
+						contact = i;
+						return true;
+					}
+				}
+				return !current.inGame[ 0 ];
+			}, maxSteps );
+		return contact;
+	}
+
+
+	float reward( int pocketedMask )
+	{
+		float result = 0.f;
+		for ( int i = 1; i < PhysicTable::numBalls; i++ )
+			if ( pocketedMask & ( 1 << i ) )
+				result += 1.f;
+		if ( isScratch( pocketedMask ) )
+			result -= Params::Env::scratchPenalty;
+		return result;
+	}
+
+
+	Shot randomShot( Random::Stream &stream )
+	{
+		constexpr float twoPi = 6.28318531f;
+		float const angle = stream.uniform( 0.f, twoPi );
+
+		Shot shot;
+		shot.direction = Vector2( std::cos( angle ), std::sin( angle ) );
+		shot.power = stream.uniform();
+		return shot;
+	}
+
+
+	Shot noisyShot( Shot const &shot, Random::Stream &stream, float directionNoise, float powerNoise )
+	{
+		float const angle = std::atan2( shot.direction.y, shot.direction.x ) + directionNoise * stream.normal();
+
+		Shot noisy;
+		noisy.direction = Vector2( std::cos( angle ), std::sin( angle ) );
+		noisy.power = std::max( std::min( shot.power + powerNoise * stream.normal(), 1.f ), 0.f );
+		return noisy;
+	}
+
+
+	namespace
+	{
+		float squaredDistanceToSegment( Vector2 point, Vector2 start, Vector2 end )
+		{
+			float const dx = end.x - start.x, dy = end.y - start.y;
+			float const lengthSquared = dx * dx + dy * dy;
+			float t = lengthSquared > 0.f ? ( ( point.x - start.x ) * dx + ( point.y - start.y ) * dy ) / lengthSquared : 0.f;
+			t = std::max( std::min( t, 1.f ), 0.f );
+			float const ex = start.x + t * dx - point.x, ey = start.y + t * dy - point.y;
+			return ex * ex + ey * ey;
+		}
+
+
+		// no ball but the skipped ones within contact of a ball of this radius moving along the path
+		bool isPathClear( PhysicTable const &table, Vector2 start, Vector2 end, float radius, int skip0, int skip1 )
+		{
+			for ( int i = 0; i < PhysicTable::numBalls; i++ )
+			{
+				if ( i == skip0 || i == skip1 || !table.inGame[ i ] )
+					continue;
+				float const contact = radius + table.balls[ i ].getRadius();
+				if ( squaredDistanceToSegment( table.balls[ i ].getPosition(), start, end ) < contact * contact )
+					return false;
+			}
+			return true;
+		}
+
+
+		// Balls move a whole speed per step and a contact is resolved from the cue ball's position
+		// before the overlapping step, not from the touching ghost ball. Walks the cue ball's steps
+		// and aims so that position k lies on the pocket line, for the first k whose next step
+		// overlaps the object ball: sin( aim - pot angle ) = cross( pot, target - cue ) / travelled.
+		bool correctForSteps( Vector2 cue, Vector2 target, Vector2 potDirection, float contact, float speed, Vector2 &aim )
+		{
+			float const contactSquared = contact * contact;
+			float const deceleration = Params::Physics::frictionDeceleration;
+			float const toTargetX = target.x - cue.x, toTargetY = target.y - cue.y;
+			float const offset = potDirection.x * toTargetY - potDirection.y * toTargetX;
+			float const potAngle = std::atan2( potDirection.y, potDirection.x );
+
+			float travelled = 0.f;
+			while ( speed > 0.f )
+			{
+				float const next = travelled + speed;
+				if ( travelled > std::abs( offset ) )
+				{
+					float const angle = potAngle + std::asin( offset / travelled );
+					Vector2 const candidate( std::cos( angle ), std::sin( angle ) );
+
+					float const beforeX = toTargetX - travelled * candidate.x, beforeY = toTargetY - travelled * candidate.y;
+					float const afterX = toTargetX - next * candidate.x, afterY = toTargetY - next * candidate.y;
+					if ( beforeX * beforeX + beforeY * beforeY > contactSquared && afterX * afterX + afterY * afterY <= contactSquared )
+					{
+						aim = candidate;
+						return true;
+					}
+				}
+
+				travelled = next;
+				speed = speed * speed <= deceleration * deceleration * 1.1f ? 0.f : speed - deceleration;
+			}
+			return false;
+		}
+	}
+
+
+	std::vector< Candidate > ghostBallCandidates( PhysicTable const &table, int maxCount, PocketField const* field )
+	{
+		std::vector< Candidate > candidates;
+		if ( !table.inGame[ 0 ] )
+			return candidates;
+
+		// the ghost is where the cue ball stands, the contact distance is both radii
+		float const cueRadius = table.balls[ 0 ].getRadius();
+		float const halfWidth = 0.5f * Params::Table::width - cueRadius;
+		float const halfHeight = 0.5f * Params::Table::height - cueRadius;
+		Vector2 const cue = table.balls[ 0 ].getPosition();
+
+		for ( int ball = 1; ball < PhysicTable::numBalls; ball++ )
+		{
+			if ( !table.inGame[ ball ] )
+				continue;
+			Vector2 const target = table.balls[ ball ].getPosition();
+			float const targetRadius = table.balls[ ball ].getRadius();
+			float const contact = cueRadius + targetRadius;
+
+			for ( int pocket = 0; pocket < PhysicTable::numPockets; pocket++ )
+			{
+				Vector2 const pocketPosition = Params::Table::pocketsPositions[ pocket ];
+				float const potDistance = distance( target, pocketPosition );
+				if ( potDistance == 0.f )
+					continue;
+
+				// the cue ball has to touch the object ball on the far side from the pocket
+				Vector2 const potDirection = normalizedVector( Vector2( pocketPosition.x - target.x, pocketPosition.y - target.y ) );
+				Vector2 const ghost( target.x - contact * potDirection.x, target.y - contact * potDirection.y );
+				if ( std::abs( ghost.x ) > halfWidth || std::abs( ghost.y ) > halfHeight )
+					continue;
+
+				float const aimDistance = distance( cue, ghost );
+				if ( aimDistance == 0.f )
+					continue;
+				Vector2 aim( ( ghost.x - cue.x ) / aimDistance, ( ghost.y - cue.y ) / aimDistance );
+
+				// the object ball leaves along the line of centres with the projected speed
+				float const cut = aim.x * potDirection.x + aim.y * potDirection.y;
+				if ( cut <= 0.1f )
+					continue;
+
+				if ( !isPathClear( table, cue, ghost, cueRadius, 0, ball ) || !isPathClear( table, target, pocketPosition, targetRadius, 0, ball ) )
+					continue;
+
+				// friction takes speed^2 / ( 2 * deceleration ) to stop a ball
+				float const deceleration = Params::Physics::frictionDeceleration;
+				float const speedSquared = 2.f * deceleration * ( aimDistance + Params::Bot::potSpeedMargin * potDistance / ( cut * cut ) );
+				// a little more power shifts the step phase when no step lands on the pocket line
+				float power = std::sqrt( speedSquared ) / Params::Physics::strikePower;
+				while ( power <= 1.f && !correctForSteps( cue, target, potDirection, contact, power * Params::Physics::strikePower, aim ) )
+					power *= 1.02f;
+				if ( power > 1.f )
+					continue;
+
+				Candidate candidate;
+				candidate.shot.direction = aim;
+				candidate.shot.power = power;
+				candidate.ball = ball;
+				candidate.pocket = pocket;
+				candidate.score = cut / ( aimDistance + potDistance );
+
+				// equal masses: the cue ball leaves the contact along the tangent line
+				float const along = aim.x * potDirection.x + aim.y * potDirection.y;
+				Vector2 const deflection( aim.x - along * potDirection.x, aim.y - along * potDirection.y );
+				if ( field && ( deflection.x != 0.f || deflection.y != 0.f ) )
+				{
+					for ( int scratchPocket = 0; scratchPocket < PhysicTable::numPockets; scratchPocket++ )
+					{
+						if ( field->reaches( ghost, scratchPocket, deflection ) )
+						{
+							candidate.score *= Params::Bot::scratchRiskFactor;
+							break;
+						}
+					}
+				}
+				candidates.push_back( candidate );
+			}
+		}
+
+		std::sort( candidates.begin(), candidates.end(), []( Candidate const &a, Candidate const &b ) { return a.score > b.score; } );
+		if ( int( candidates.size() ) > maxCount )
+			candidates.resize( maxCount );
+		return candidates;
+	}
+
+
+	void jitterRack( PhysicTable &table, Random::Stream &stream, float jitter )
+	{
+		for ( int i = 1; i < PhysicTable::numBalls; i++ )
+		{
+			Vector2 position = table.balls[ i ].getPosition();
+			position.x += stream.uniform( -jitter, jitter );
+			position.y += stream.uniform( -jitter, jitter );
+			table.balls[ i ].setPosition( position );
+		}
+	}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+
+#include "physics.hpp"
+#include "pocketability.hpp"
+#include "random.hpp"
+
+
+//-------------------------------------------------------
+//	Randomised shots and tables
+//
+//	All randomness comes from Random::Stream, so callers
+//	pick the ( table, shot ) key and get the same result on
+//	any thread.
+//-------------------------------------------------------
+
+namespace Shots
+{
+	struct Outcome
+	{
+		PhysicTable table;
+		int pocketedMask = 0;
+		int steps = 0;
+		float elapsed = 0.f;	// in base steps, the same as steps unless the steps were adaptive
+		bool settled = false;	// false if the shot was cut off at maxSteps or stopped
+		bool stopped = false;	// the stop predicate ended the run
+	};
+
+	// strikes a copy of the table and steps it until it rests
+	Outcome play( PhysicTable const &table, Shot const &shot, int maxSteps = Params::Env::maxShotSteps );
+
+	// Same with PhysicTable::adaptiveStepSize steps, maxSteps counts base steps. Far fewer
+	// steps for the slow end of a shot, but not the same result as the base steps.
+	Outcome playAdaptive( PhysicTable const &table, Shot const &shot, int maxSteps = Params::Env::maxShotSteps );
+
+	// Same, but after every step whose event kinds intersect eventFilter ( StepEvents::Kind flags )
+	// stop( table, events ) decides whether the outcome is already known; the run ends on true.
+	// Steps without a matching event don't call the predicate at all.
+	template< typename Stop >
+	Outcome playUntil( PhysicTable const &table, Shot const &shot, int eventFilter, Stop &&stop, int maxSteps = Params::Env::maxShotSteps );
+
+	// speculative questions that exit as soon as they're answered
+	bool isBallPocketed( PhysicTable const &table, Shot const &shot, int ball, int maxSteps = Params::Env::maxShotSteps );
+	bool isScratch( PhysicTable const &table, Shot const &shot, int maxSteps = Params::Env::maxShotSteps );
+	// the same for a shot already played
+	inline bool isScratch( int pocketedMask ) { return ( pocketedMask & 1 ) != 0; }
+	// first ball the cue ball touches, -1 if none
+	int firstContact( PhysicTable const &table, Shot const &shot, int maxSteps = Params::Env::maxShotSteps );
+
+	// object balls pocketed minus the scratch penalty, the score of the env and the planner
+	float reward( int pocketedMask );
+
+	// uniform direction and power
+	Shot randomShot( Random::Stream &stream );
+
+	// execution noise: gaussian error on the direction angle and the power
+	Shot noisyShot( Shot const &shot, Random::Stream &stream, float directionNoise = Params::Random::directionNoise, float powerNoise = Params::Random::powerNoise );
+
+	// a pot along the straight line cue ball - ghost ball - object ball - pocket
+	struct Candidate
+	{
+		Shot shot;
+		int ball = 0;
+		int pocket = 0;
+		float score = 0.f;		// higher is easier
+	};
+
+	// Ghost ball aim points for every object ball and pocket with clear paths, best first.
+	// With a field, pots whose cue ball deflection runs straight into a pocket rank lower.
+	std::vector< Candidate > ghostBallCandidates( PhysicTable const &table, int maxCount = Params::Bot::ghostCandidates, PocketField const* field = nullptr );
+
+	// moves every rack ball by a uniform offset, the player ball keeps its spot
+	void jitterRack( PhysicTable &table, Random::Stream &stream, float jitter = Params::Random::rackJitter );
+}
+
+
+template< typename Stop >
+Shots::Outcome Shots::playUntil( PhysicTable const &table, Shot const &shot, int eventFilter, Stop &&stop, int maxSteps )
+{
+	Outcome outcome;
+	outcome.table = table;
+	outcome.table.strike( shot );
+
+	while ( outcome.steps < maxSteps && !outcome.table.isResting() )
+	{
+		StepEvents const events = outcome.table.stepEvents();
+		outcome.pocketedMask |= events.pocketedMask;
+		outcome.steps++;
+		outcome.elapsed += 1.f;
+
+		if ( ( events.kinds() & eventFilter ) && stop( static_cast< PhysicTable const& >( outcome.table ), events ) )
+		{
+			outcome.stopped = true;
+			return outcome;
+		}
+	}
+	outcome.settled = outcome.table.isResting();
+	return outcome;
+}
@@ -0,0 +1,158 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "spatial_grid.hpp"
+
+
+void SpatialGrid::init( float left, float bottom, float width, float height, float cellSize, int items )
+{
+	this->left = left;
+	this->bottom = bottom;
+	inverseCellSize = 1.f / cellSize;
+	columns = std::max( int( std::ceil( width / cellSize ) ), 1 );
+	rows = std::max( int( std::ceil( height / cellSize ) ), 1 );
+
+	cellCount.assign( size_t( columns ) * rows, 0 );
+	cellSlots.assign( size_t( columns ) * rows * capacity, -1 );
+	cellCrowded.assign( size_t( columns ) * rows, -1 );
+	itemCell.assign( items, -1 );
+	itemSlot.assign( items, -1 );
+	nextCrowded.assign( items, -1 );
+	previousCrowded.assign( items, -1 );
+}
+
+
+int SpatialGrid::cellAt( float x, float y ) const
+{
+	int const column = std::min( std::max( int( ( x - left ) * inverseCellSize ), 0 ), columns - 1 );
+	int const row = std::min( std::max( int( ( y - bottom ) * inverseCellSize ), 0 ), rows - 1 );
+	return row * columns + column;
+}
+
+
+void SpatialGrid::insert( int item, int cell )
+{
+	assert( itemCell[ item ] < 0 && cellCount[ cell ] < 255 );
+	itemCell[ item ] = cell;
+
+	int const count = cellCount[ cell ]++;
+	if ( count < capacity )
+	{
+		cellSlots[ size_t( cell ) * capacity + count ] = item;
+		itemSlot[ item ] = count;
+		return;
+	}
+
+	itemSlot[ item ] = -1;
+	previousCrowded[ item ] = -1;
+	nextCrowded[ item ] = cellCrowded[ cell ];
+	if ( cellCrowded[ cell ] >= 0 )
+		previousCrowded[ cellCrowded[ cell ] ] = item;
+	cellCrowded[ cell ] = item;
+}
+
+
+void SpatialGrid::remove( int item )
+{
+	int const cell = itemCell[ item ];
+	int const slot = itemSlot[ item ];
+	int* const slots = &cellSlots[ size_t( cell ) * capacity ];
+	int const count = --cellCount[ cell ];
+	itemCell[ item ] = -1;
+
+	auto unlink = [ this, cell ]( int crowded )
+	{
+		if ( previousCrowded[ crowded ] >= 0 )
+			nextCrowded[ previousCrowded[ crowded ] ] = nextCrowded[ crowded ];
+		else
+			cellCrowded[ cell ] = nextCrowded[ crowded ];
+		if ( nextCrowded[ crowded ] >= 0 )
+			previousCrowded[ nextCrowded[ crowded ] ] = previousCrowded[ crowded ];
+	};
+
+	if ( slot < 0 )
+	{
+		unlink( item );
+		return;
+	}
+
+	// the slots stay packed: the first crowded item moves up, or the last slot fills the hole
+	if ( count >= capacity )
+	{
+		int const crowded = cellCrowded[ cell ];
+		unlink( crowded );
+		slots[ slot ] = crowded;
+		itemSlot[ crowded ] = slot;
+	}
+	else if ( slot != count )
+	{
+		slots[ slot ] = slots[ count ];
+		itemSlot[ slots[ slot ] ] = slot;
+	}
+}
+
+
+bool SpatialGrid::move( int item, int cell )
+{
+	if ( itemCell[ item ] == cell )
+		return false;
+	remove( item );
+	insert( item, cell );
+	return true;
+}
+
+
+//-------------------------------------------------------
+//	Hierarchical grid
+//-------------------------------------------------------
+
+void HierarchicalGrid::init( float left, float bottom, float width, float height, std::vector< float > const &radii )
+{
+	int const items = int( radii.size() );
+	minRadius = items ? *std::min_element( radii.begin(), radii.end() ) : 1.f;
+	float const maxRadius = items ? *std::max_element( radii.begin(), radii.end() ) : 1.f;
+
+	int const count = int( std::log2( maxRadius / minRadius ) ) + 1;
+	levels.resize( count );
+	std::vector< float > largest( count, 0.f );
+	for ( float radius : radii )
+	{
+		int const index = levelFor( radius );
+		largest[ index ] = std::max( largest[ index ], radius );
+	}
+
+	// an empty class keeps the cell of the largest radius it could hold
+	for ( int index = 0; index < count; index++ )
+	{
+		float const radius = largest[ index ] > 0.f ? largest[ index ] : minRadius * float( 2 << index );
+		levels[ index ].init( left, bottom, width, height, 2.f * radius, items );
+	}
+	levelItems.assign( count, 0 );
+	itemLevel.assign( items, 0 );
+}
+
+
+int HierarchicalGrid::levelFor( float radius ) const
+{
+	int index = 0;
+	while ( index + 1 < int( levels.size() ) && radius >= minRadius * float( 2 << index ) )
+		index++;
+	return index;
+}
+
+
+void HierarchicalGrid::insert( int item, float x, float y, float radius )
+{
+	int const index = levelFor( radius );
+	itemLevel[ item ] = uint8_t( index );
+	levelItems[ index ]++;
+	levels[ index ].insert( item, levels[ index ].cellAt( x, y ) );
+}
+
+
+bool HierarchicalGrid::move( int item, float x, float y )
+{
+	SpatialGrid &grid = levels[ itemLevel[ item ] ];
+	return grid.move( item, grid.cellAt( x, y ) );
+}
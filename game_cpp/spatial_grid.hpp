@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+//-------------------------------------------------------
+//	Incremental uniform grid
+//
+//	Every item remembers its cell, so moving one costs
+//	nothing until it crosses into another cell and then one
+//	O( 1 ) remove and insert. A cell is capacity slots in
+//	one flat array; the rare item that finds its cell full
+//	goes to a list of the cell's crowded items, linked
+//	through the items.
+//	Within a cell the order follows the history of inserts
+//	and removes, the same for the same sequence of calls.
+//-------------------------------------------------------
+
+class SpatialGrid
+{
+public:
+	static constexpr int capacity = 4;
+
+	// a grid of square cells covering [ left, left + width ) x [ bottom, bottom + height )
+	void init( float left, float bottom, float width, float height, float cellSize, int items );
+
+	int getColumns() const { return columns; }
+	int getRows() const { return rows; }
+	float getCellSize() const { return 1.f / inverseCellSize; }
+	// clamped to the grid
+	int cellAt( float x, float y ) const;
+	int cellOf( int item ) const { return itemCell[ item ]; }
+
+	void insert( int item, int cell );
+	void remove( int item );
+	// returns true if the item changed cells
+	bool move( int item, int cell );
+
+	// visit( item ) for the items in the cell
+	template< typename Visit >
+	void forEachInCell( int cell, Visit &&visit ) const;
+
+private:
+	float left = 0.f;
+	float bottom = 0.f;
+	float inverseCellSize = 1.f;
+	int columns = 0;
+	int rows = 0;
+
+	std::vector< uint8_t > cellCount;		// slotted and crowded items
+	std::vector< int > cellSlots;			// capacity per cell
+	std::vector< int > cellCrowded;			// first crowded item, -1 if none
+	std::vector< int > itemCell;
+	std::vector< int > itemSlot;			// slot in the cell, -1 if crowded
+	std::vector< int > nextCrowded;
+	std::vector< int > previousCrowded;
+};
+
+
+template< typename Visit >
+void SpatialGrid::forEachInCell( int cell, Visit &&visit ) const
+{
+	int const count = cellCount[ cell ];
+	int const slotted = count < capacity ? count : capacity;
+	int const* const slots = &cellSlots[ size_t( cell ) * capacity ];
+	for ( int k = 0; k < slotted; k++ )
+		visit( slots[ k ] );
+
+	if ( count > capacity )
+		for ( int item = cellCrowded[ cell ]; item >= 0; item = nextCrowded[ item ] )
+			visit( item );
+}
+
+
+//-------------------------------------------------------
+//	Hierarchical grid for mixed radii
+//
+//	Levels of SpatialGrid for radius classes doubling from
+//	the smallest radius, level k holds the radii in
+//	[ min * 2^k, min * 2^( k + 1 ) ). A level's cell is the
+//	largest diameter of its class, so every item's cell is
+//	within a factor of two of its diameter and no level's
+//	cell size is tuned for the biggest item. A query walks
+//	every level, widened by that level's largest radius; on
+//	the query's own level that is the usual 3 x 3 cells.
+//-------------------------------------------------------
+
+class HierarchicalGrid
+{
+public:
+	// one item per radius, the radii size the levels
+	void init( float left, float bottom, float width, float height, std::vector< float > const &radii );
+
+	int levelCount() const { return int( levels.size() ); }
+	SpatialGrid const& level( int index ) const { return levels[ index ]; }
+	int levelFor( float radius ) const;
+
+	void insert( int item, float x, float y, float radius );
+	// the item stays on its level, returns true if it changed cells
+	bool move( int item, float x, float y );
+
+	// visit( item ) for every item that could be within reach + its own radius of the point
+	template< typename Visit >
+	void forEachNear( float x, float y, float reach, Visit &&visit ) const;
+
+private:
+	float minRadius = 0.f;
+	std::vector< SpatialGrid > levels;
+	std::vector< int > levelItems;
+	std::vector< uint8_t > itemLevel;
+};
+
+
+template< typename Visit >
+void HierarchicalGrid::forEachNear( float x, float y, float reach, Visit &&visit ) const
+{
+	for ( size_t index = 0; index < levels.size(); index++ )
+	{
+		if ( levelItems[ index ] == 0 )
+			continue;
+
+		SpatialGrid const &grid = levels[ index ];
+		float const range = reach + 0.5f * grid.getCellSize();
+		int const columns = grid.getColumns();
+		int const low = grid.cellAt( x - range, y - range );
+		int const high = grid.cellAt( x + range, y + range );
+
+		for ( int row = low / columns; row <= high / columns; row++ )
+			for ( int column = low % columns; column <= high % columns; column++ )
+				grid.forEachInCell( row * columns + column, visit );
+	}
+}
@@ -0,0 +1,719 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <numeric>
+#include <type_traits>
+
+#include "hashing.hpp"
+#include "random.hpp"
+#include "stress.hpp"
+#include "vector2.hpp"
+
+
+namespace Stress
+{
+	namespace
+	{
+		// one colour past the mask takes the contacts that found none free, resolved serially
+		constexpr int maxColours = 64;
+
+
+		// spreads the low 16 bits to the even bits
+		uint32_t interleave( uint32_t value )
+		{
+			value &= 0xFFFF;
+			value = ( value | ( value << 8 ) ) & 0x00FF00FF;
+			value = ( value | ( value << 4 ) ) & 0x0F0F0F0F;
+			value = ( value | ( value << 2 ) ) & 0x33333333;
+			value = ( value | ( value << 1 ) ) & 0x55555555;
+			return value;
+		}
+
+
+		uint32_t bitsOf( float value )
+		{
+			uint32_t bits;
+			std::memcpy( &bits, &value, sizeof( bits ) );
+			return bits;
+		}
+	}
+
+
+	//-------------------------------------------------------
+	//	Setup
+	//-------------------------------------------------------
+
+	// Big balls first at random spots clear of each other, then the rest on a jittered
+	// lattice around them. Balls take their spots in random order, so neighbours aren't
+	// neighbours in memory.
+	void Table::reset( int count, uint32_t seed, float density )
+	{
+		Random::Stream stream( 0, 0, Random::Purpose::stress, seed );
+
+		radius.resize( count );
+		inverseMass.resize( count );
+		float ballsArea = 0.f;
+		for ( int i = 0; i < count; i++ )
+		{
+			float pick = stream.uniform();
+			size_t kind = 0;
+			while ( kind + 1 < Params::Stress::radii.size() && pick >= Params::Stress::radiusShares[ kind ] )
+				pick -= Params::Stress::radiusShares[ kind++ ];
+			radius[ i ] = Params::Stress::radii[ kind ];
+			// solid balls of one material, the mass goes with the volume
+			float const scale = radius[ i ] / Params::Ball::radius;
+			inverseMass[ i ] = 1.f / ( Params::Ball::mass * scale * scale * scale );
+			ballsArea += 3.14159265f * radius[ i ] * radius[ i ];
+		}
+
+		float const aspect = Params::Table::width / Params::Table::height;
+		height = std::sqrt( ballsArea / density / aspect );
+		width = height * aspect;
+
+		positionX.resize( count );
+		positionY.resize( count );
+		speedX.resize( count );
+		speedY.resize( count );
+		initGrid();
+
+		auto isClear = [ this ]( float x, float y, float reach )
+		{
+			bool clear = true;
+			grid.forEachNear( x, y, reach, [ &, x, y ]( int other )
+			{
+				float const dx = positionX[ other ] - x, dy = positionY[ other ] - y;
+				float const gap = reach + radius[ other ];
+				clear = clear && dx * dx + dy * dy > gap * gap;
+			} );
+			return clear;
+		};
+
+		std::vector< int > small;
+		for ( int i = 0; i < count; i++ )
+		{
+			if ( radius[ i ] <= Params::Ball::radius )
+			{
+				small.push_back( i );
+				continue;
+			}
+			for ( int attempt = 0; attempt < 1000; attempt++ )
+			{
+				positionX[ i ] = stream.uniform( -0.5f * width + radius[ i ], 0.5f * width - radius[ i ] );
+				positionY[ i ] = stream.uniform( -0.5f * height + radius[ i ], 0.5f * height - radius[ i ] );
+				if ( isClear( positionX[ i ], positionY[ i ], radius[ i ] ) )
+					break;
+			}
+			grid.insert( i, positionX[ i ], positionY[ i ], radius[ i ] );
+		}
+
+		// the finest lattice with a free site for every small ball
+		float spacing = std::sqrt( width * height / float( small.size() + 1 ) );
+		std::vector< Vector2 > sites;
+		for ( ;; )
+		{
+			sites.clear();
+			int const columns = int( width / spacing ), rows = int( height / spacing );
+			for ( int row = 0; row < rows; row++ )
+			{
+				for ( int column = 0; column < columns; column++ )
+				{
+					Vector2 const site( -0.5f * width + ( column + 0.5f ) * spacing, -0.5f * height + ( row + 0.5f ) * spacing );
+					if ( isClear( site.x, site.y, 0.5f * spacing ) )
+						sites.push_back( site );
+				}
+			}
+			if ( sites.size() >= small.size() )
+				break;
+			spacing *= 0.99f;
+		}
+		assert( spacing > 2.f * Params::Ball::radius );
+
+		// counts down from the size, a table with no small ball has no site
+		for ( size_t k = sites.size(); k > 1; k-- )
+			std::swap( sites[ k - 1 ], sites[ stream.nextBits() % uint32_t( k ) ] );
+		for ( size_t k = 0; k < small.size(); k++ )
+		{
+			int const i = small[ k ];
+			float const jitter = 0.5f * spacing - radius[ i ];
+			positionX[ i ] = sites[ k ].x + stream.uniform( -jitter, jitter );
+			positionY[ i ] = sites[ k ].y + stream.uniform( -jitter, jitter );
+			// a corner of the site may reach into a big ball, its middle never does
+			if ( !isClear( positionX[ i ], positionY[ i ], radius[ i ] ) )
+			{
+				positionX[ i ] = sites[ k ].x;
+				positionY[ i ] = sites[ k ].y;
+			}
+			grid.insert( i, positionX[ i ], positionY[ i ], radius[ i ] );
+		}
+
+		for ( int i = 0; i < count; i++ )
+		{
+			float const angle = stream.uniform( 0.f, 6.28318531f );
+			float const speed = stream.uniform( 0.f, Params::Stress::maxInitialSpeed );
+			speedX[ i ] = std::cos( angle ) * speed;
+			speedY[ i ] = std::sin( angle ) * speed;
+		}
+
+		awake.clear();
+		isAwake.assign( count, 0 );
+		for ( int i = 0; i < count; i++ )
+		{
+			if ( speedX[ i ] != 0.f || speedY[ i ] != 0.f )
+			{
+				isAwake[ i ] = 1;
+				awake.push_back( i );
+			}
+		}
+
+		parent.resize( count );
+		for ( int i = 0; i < count; i++ )
+			parent[ i ] = i;
+		rootIsland.assign( count, -1 );
+		usedColours.assign( count, 0 );
+
+		pairCache.assign( count, {} );
+		stepIndex = 1;
+
+		ids.resize( count );
+		indices.resize( count );
+		std::iota( ids.begin(), ids.end(), 0 );
+		std::iota( indices.begin(), indices.end(), 0 );
+	}
+
+
+	// Sorts the storage by the Morton code of the grid cell, so balls close on the table
+	// are close in memory. Ties keep their order, the result depends on the state only.
+	int Table::reorder()
+	{
+		int const count = size();
+		SpatialGrid const &finest = grid.level( 0 );
+		int const columns = finest.getColumns();
+
+		std::vector< uint64_t > keys( count );
+		for ( int i = 0; i < count; i++ )
+		{
+			int const cell = finest.cellAt( positionX[ i ], positionY[ i ] );
+			keys[ i ] = uint64_t( interleave( uint32_t( cell % columns ) ) | interleave( uint32_t( cell / columns ) ) << 1 ) << 32 | uint32_t( i );
+		}
+		std::sort( keys.begin(), keys.end() );
+
+		// order[ k ] is the old index of the ball now stored at k, moved the other way
+		std::vector< int > order( count ), moved( count );
+		for ( int k = 0; k < count; k++ )
+		{
+			order[ k ] = int( keys[ k ] & 0xFFFFFFFFu );
+			moved[ order[ k ] ] = k;
+		}
+
+		auto permute = [ &order, count ]( auto &values )
+		{
+			std::remove_reference_t< decltype( values ) > sorted( count );
+			for ( int k = 0; k < count; k++ )
+				sorted[ k ] = values[ order[ k ] ];
+			values.swap( sorted );
+		};
+		permute( positionX );
+		permute( positionY );
+		permute( speedX );
+		permute( speedY );
+		permute( radius );
+		permute( inverseMass );
+		permute( isAwake );
+		permute( ids );
+		for ( int k = 0; k < count; k++ )
+			indices[ ids[ k ] ] = k;
+
+		for ( int &ball : awake )
+			ball = moved[ ball ];
+		std::sort( awake.begin(), awake.end() );
+
+		// The new order may change the lower ball of a pair, which keeps it if it has a slot
+		// left and else hands it to the other ball. Only pairs of the last step can warm start.
+		int dropped = 0;
+		std::vector< std::array< PairSlot, pairSlots > > cache( count );
+		for ( int owner = 0; owner < count; owner++ )
+		{
+			for ( PairSlot const &slot : pairCache[ owner ] )
+			{
+				if ( slot.other < 0 || slot.step + 1 != stepIndex )
+					continue;
+				int const a = moved[ owner ], b = moved[ slot.other ];
+				bool kept = false;
+				for ( int keeper : { std::min( a, b ), std::max( a, b ) } )
+				{
+					for ( PairSlot &target : cache[ keeper ] )
+					{
+						if ( !kept && target.other < 0 )
+						{
+							target = { keeper == a ? b : a, slot.step, slot.impulse };
+							kept = true;
+						}
+					}
+				}
+				dropped += kept ? 0 : 1;
+			}
+		}
+		pairCache.swap( cache );
+
+		initGrid();
+		for ( int i = 0; i < count; i++ )
+			grid.insert( i, positionX[ i ], positionY[ i ], radius[ i ] );
+		return dropped;
+	}
+
+
+	void Table::initGrid()
+	{
+		grid.init( -0.5f * width, -0.5f * height, width, height, radius );
+	}
+
+
+	//-------------------------------------------------------
+	//	Step
+	//-------------------------------------------------------
+
+	StepStats Table::step( Workers &workers )
+	{
+		StepStats stats;
+		if ( reorderInterval > 0 && stepIndex % uint32_t( reorderInterval ) == 0 )
+			stats.droppedPairs = reorder();
+		stats.awake = int( awake.size() );
+
+		stats.crossings = integrate( workers );
+		findContacts( workers );
+		stats.contacts = int( contacts.size() );
+		for ( Contact const &contact : contacts )
+			stats.contactSpan += std::abs( contact.first - contact.second );
+
+		findIslands();
+		stats.islands = int( islandStart.size() ) - 1;
+		stats.colours = resolveIslands( workers, stats.sweeps );
+		stats.droppedPairs += droppedPairs.exchange( 0 );
+
+		wake();
+		stepIndex++;
+		return stats;
+	}
+
+
+	// Friction, move and cushions, the same sequence as PhysicTable::stepEvents. Only the
+	// awake balls move, the ones friction stops fall asleep until a contact wakes them.
+	// Returns the balls that crossed into another grid cell.
+	int Table::integrate( Workers &workers )
+	{
+		workers.parallelFor( int( awake.size() ), [ this ]( int begin, int end )
+		{
+			float const deceleration = Params::Physics::frictionDeceleration;
+			for ( int k = begin; k < end; k++ )
+			{
+				int const i = awake[ k ];
+				float const halfWidth = 0.5f * width - radius[ i ];
+				float const halfHeight = 0.5f * height - radius[ i ];
+				float vx = speedX[ i ], vy = speedY[ i ];
+
+				float x = positionX[ i ] + vx;
+				float y = positionY[ i ] + vy;
+
+				float const speedSquared = vx * vx + vy * vy;
+				if ( speedSquared <= deceleration * deceleration * 1.1f )
+					vx = vy = 0.f;
+				else
+				{
+					float const scale = deceleration / std::sqrt( speedSquared );
+					vx -= vx * scale;
+					vy -= vy * scale;
+				}
+
+				if ( x > halfWidth ) { x = 2.f * halfWidth - x; vx = -vx; }
+				if ( x < -halfWidth ) { x = -2.f * halfWidth - x; vx = -vx; }
+				if ( y > halfHeight ) { y = 2.f * halfHeight - y; vy = -vy; }
+				if ( y < -halfHeight ) { y = -2.f * halfHeight - y; vy = -vy; }
+
+				positionX[ i ] = x;
+				positionY[ i ] = y;
+				speedX[ i ] = vx;
+				speedY[ i ] = vy;
+			}
+		} );
+
+		// Stopped balls leave the list, which stays in index order. The grid is updated in
+		// that order too, so the order within its cells doesn't depend on the workers.
+		int crossings = 0;
+		size_t kept = 0;
+		for ( int i : awake )
+		{
+			crossings += grid.move( i, positionX[ i ], positionY[ i ] );
+			if ( speedX[ i ] != 0.f || speedY[ i ] != 0.f )
+				awake[ kept++ ] = i;
+			else
+				isAwake[ i ] = 0;
+		}
+		awake.resize( kept );
+		return crossings;
+	}
+
+
+	// Pairs closer than their radii with at least one ball awake, two sleeping balls never
+	// collide. Touching pairs moving apart are kept, another contact can push them together.
+	// Each worker scans a run of the awake list around its balls and the runs are joined
+	// in order, so the list doesn't depend on the worker count.
+	void Table::findContacts( Workers &workers )
+	{
+		workerContacts.resize( workers.count() );
+		workers.run( [ this, &workers ]( int worker )
+		{
+			std::vector< Contact > &found = workerContacts[ worker ];
+			found.clear();
+
+			int const first = int( int64_t( awake.size() ) * worker / workers.count() );
+			int const last = int( int64_t( awake.size() ) * ( worker + 1 ) / workers.count() );
+
+			for ( int k = first; k < last; k++ )
+			{
+				int const a = awake[ k ];
+				grid.forEachNear( positionX[ a ], positionY[ a ], radius[ a ], [ this, a, &found ]( int b )
+				{
+					// a pair of awake balls is found from the lower one
+					if ( b == a || ( isAwake[ b ] && b < a ) )
+						return;
+
+					float const dx = positionX[ b ] - positionX[ a ];
+					float const dy = positionY[ b ] - positionY[ a ];
+					float const reach = radius[ a ] + radius[ b ];
+					if ( dx * dx + dy * dy <= reach * reach )
+						found.push_back( { a, b } );
+				} );
+			}
+		} );
+
+		contacts.clear();
+		for ( std::vector< Contact > const &found : workerContacts )
+			contacts.insert( contacts.end(), found.begin(), found.end() );
+	}
+
+
+	int Table::findRoot( int ball )
+	{
+		while ( parent[ ball ] != ball )
+		{
+			parent[ ball ] = parent[ parent[ ball ] ];
+			ball = parent[ ball ];
+		}
+		return ball;
+	}
+
+
+	// Union-find over the contacts, the lower root wins so the islands don't depend on the
+	// union order. Islands are numbered by first contact and keep their contacts in order.
+	void Table::findIslands()
+	{
+		for ( Contact const &contact : contacts )
+		{
+			int const first = findRoot( contact.first ), second = findRoot( contact.second );
+			if ( first != second )
+				parent[ std::max( first, second ) ] = std::min( first, second );
+		}
+
+		contactIsland.resize( contacts.size() );
+		islandStart.assign( 1, 0 );
+		for ( size_t k = 0; k < contacts.size(); k++ )
+		{
+			int const root = findRoot( contacts[ k ].first );
+			if ( rootIsland[ root ] < 0 )
+			{
+				rootIsland[ root ] = int( islandStart.size() ) - 1;
+				islandStart.push_back( 0 );
+			}
+			contactIsland[ k ] = rootIsland[ root ];
+			islandStart[ rootIsland[ root ] + 1 ]++;
+		}
+		for ( size_t island = 1; island < islandStart.size(); island++ )
+			islandStart[ island ] += islandStart[ island - 1 ];
+
+		islandContacts.resize( contacts.size() );
+		sortCursors.assign( islandStart.begin(), islandStart.end() - 1 );
+		for ( size_t k = 0; k < contacts.size(); k++ )
+			islandContacts[ sortCursors[ contactIsland[ k ] ]++ ] = contacts[ k ];
+
+		// only the balls in contacts were touched, put them back for the next step
+		for ( Contact const &contact : contacts )
+			rootIsland[ findRoot( contact.first ) ] = -1;
+		for ( Contact const &contact : contacts )
+		{
+			parent[ contact.first ] = contact.first;
+			parent[ contact.second ] = contact.second;
+		}
+	}
+
+
+	// The separating speed the contact aims for is the approach speed before the solve, the
+	// collision is elastic, and zero for a pair already moving apart. The warm start applies
+	// the impulse the pair took last step up front.
+	void Table::prepare( Contact &contact )
+	{
+		int const a = contact.first, b = contact.second;
+		float const dx = positionX[ b ] - positionX[ a ];
+		float const dy = positionY[ b ] - positionY[ a ];
+		float const length = std::sqrt( dx * dx + dy * dy );
+		if ( length == 0.f )
+		{
+			contact.normalX = contact.normalY = contact.target = contact.impulse = 0.f;
+			return;
+		}
+		contact.normalX = dx / length;
+		contact.normalY = dy / length;
+
+		float const separating = contact.normalX * ( speedX[ b ] - speedX[ a ] ) + contact.normalY * ( speedY[ b ] - speedY[ a ] );
+		contact.target = std::max( -separating, 0.f );
+
+		contact.impulse = 0.f;
+		if ( !warmStarting )
+			return;
+		contact.impulse = cachedImpulse( a, b );
+		speedX[ a ] -= contact.normalX * contact.impulse * inverseMass[ a ];
+		speedY[ a ] -= contact.normalY * contact.impulse * inverseMass[ a ];
+		speedX[ b ] += contact.normalX * contact.impulse * inverseMass[ b ];
+		speedY[ b ] += contact.normalY * contact.impulse * inverseMass[ b ];
+	}
+
+
+	// One Gauss-Seidel update of the accumulated impulse, which never pulls the balls
+	// together. The change in separating speed is shared by the inverse masses, equal
+	// masses split it in two.
+	void Table::solve( Contact &contact )
+	{
+		int const a = contact.first, b = contact.second;
+		float const separating = contact.normalX * ( speedX[ b ] - speedX[ a ] ) + contact.normalY * ( speedY[ b ] - speedY[ a ] );
+		float const impulse = std::max( contact.impulse + ( contact.target - separating ) / ( inverseMass[ a ] + inverseMass[ b ] ), 0.f );
+		float const change = impulse - contact.impulse;
+		contact.impulse = impulse;
+		contact.change = change;
+
+		speedX[ a ] -= contact.normalX * change * inverseMass[ a ];
+		speedY[ a ] -= contact.normalY * change * inverseMass[ a ];
+		speedX[ b ] += contact.normalX * change * inverseMass[ b ];
+		speedY[ b ] += contact.normalY * change * inverseMass[ b ];
+	}
+
+
+	// the impulse the pair took last step, kept by either ball, 0 if it didn't touch
+	float Table::cachedImpulse( int a, int b ) const
+	{
+		for ( int keeper : { std::min( a, b ), std::max( a, b ) } )
+		{
+			int const other = keeper == a ? b : a;
+			for ( PairSlot const &slot : pairCache[ keeper ] )
+				if ( slot.other == other && slot.step + 1 == stepIndex )
+					return slot.impulse;
+		}
+		return 0.f;
+	}
+
+
+	// The pair's slot if either ball has one, else the stalest slot of the lower ball or of
+	// the higher one if that's staler. Taking over a slot of this step loses a touching pair.
+	void Table::cacheImpulse( Contact const &contact )
+	{
+		PairSlot* chosen = nullptr;
+		int chosenOther = -1;
+		for ( int keeper : { std::min( contact.first, contact.second ), std::max( contact.first, contact.second ) } )
+		{
+			int const other = keeper == contact.first ? contact.second : contact.first;
+			for ( PairSlot &slot : pairCache[ keeper ] )
+			{
+				if ( slot.other == other )
+				{
+					slot = { other, stepIndex, contact.impulse };
+					return;
+				}
+				if ( !chosen || slot.step < chosen->step )
+				{
+					chosen = &slot;
+					chosenOther = other;
+				}
+			}
+		}
+
+		if ( chosen->step == stepIndex )
+			droppedPairs++;
+		*chosen = { chosenOther, stepIndex, contact.impulse };
+	}
+
+
+	// Islands share no balls, so each is solved whole by one worker, contacts in order and
+	// sweeps until no impulse changes by Params::Stress::solverTolerance. An island over
+	// Params::Stress::maxIslandContacts would leave the others waiting on it and is split by
+	// colours instead. Returns the most colours an island needed.
+	int Table::resolveIslands( Workers &workers, int &sweeps )
+	{
+		int const islands = int( islandStart.size() ) - 1;
+		smallIslands.clear();
+		largeIslands.clear();
+		for ( int island = 0; island < islands; island++ )
+		{
+			if ( islandStart[ island + 1 ] - islandStart[ island ] > Params::Stress::maxIslandContacts )
+				largeIslands.push_back( island );
+			else
+				smallIslands.push_back( island );
+		}
+
+		islandSweeps.resize( smallIslands.size() );
+		workers.parallelFor( int( smallIslands.size() ), [ this ]( int begin, int end )
+		{
+			for ( int k = begin; k < end; k++ )
+			{
+				Contact* const first = islandContacts.data() + islandStart[ smallIslands[ k ] ];
+				Contact* const last = islandContacts.data() + islandStart[ smallIslands[ k ] + 1 ];
+				for ( Contact* contact = first; contact != last; contact++ )
+					prepare( *contact );
+
+				int sweep = 0;
+				float largest = 0.f;
+				do
+				{
+					largest = 0.f;
+					for ( Contact* contact = first; contact != last; contact++ )
+					{
+						solve( *contact );
+						largest = std::max( largest, std::abs( contact->change ) );
+					}
+					sweep++;
+				} while ( sweep < Params::Stress::solverSweeps && largest > Params::Stress::solverTolerance );
+				islandSweeps[ k ] = sweep;
+
+				for ( Contact* contact = first; contact != last; contact++ )
+					cacheImpulse( *contact );
+			}
+		} );
+		for ( int sweep : islandSweeps )
+			sweeps += sweep;
+
+		int mostColours = 0;
+		for ( int island : largeIslands )
+		{
+			int const colours = colourContacts( islandStart[ island ], islandStart[ island + 1 ] );
+			sweeps += resolveColours( workers, colours );
+			mostColours = std::max( mostColours, colours );
+		}
+		return mostColours;
+	}
+
+
+	// greedy colouring in contact order, each contact takes the lowest colour free at both balls
+	int Table::colourContacts( int begin, int end )
+	{
+		contactColour.resize( end - begin );
+
+		int colours = 0;
+		std::vector< int > counts( maxColours + 1, 0 );
+		for ( int k = begin; k < end; k++ )
+		{
+			Contact const &contact = islandContacts[ k ];
+			uint64_t const taken = usedColours[ contact.first ] | usedColours[ contact.second ];
+			int colour = 0;
+			while ( colour < maxColours && ( ( taken >> colour ) & 1 ) )
+				colour++;
+			if ( colour < maxColours )
+			{
+				usedColours[ contact.first ] |= uint64_t( 1 ) << colour;
+				usedColours[ contact.second ] |= uint64_t( 1 ) << colour;
+			}
+			contactColour[ k - begin ] = uint8_t( colour );
+			counts[ colour ]++;
+			colours = std::max( colours, colour + 1 );
+		}
+
+		colourStart.assign( colours + 1, 0 );
+		for ( int c = 0; c < colours; c++ )
+			colourStart[ c + 1 ] = colourStart[ c ] + counts[ c ];
+
+		coloured.resize( end - begin );
+		sortCursors.assign( colourStart.begin(), colourStart.end() - 1 );
+		for ( int k = begin; k < end; k++ )
+		{
+			Contact const &contact = islandContacts[ k ];
+			coloured[ sortCursors[ contactColour[ k - begin ] ]++ ] = contact;
+			usedColours[ contact.first ] = 0;
+			usedColours[ contact.second ] = 0;
+		}
+		return colours;
+	}
+
+
+	// Within a colour no two contacts share a ball, so they run in any order on any thread.
+	// Every sweep runs the colours one after another. Returns the sweeps taken.
+	int Table::resolveColours( Workers &workers, int colours )
+	{
+		auto forEachColour = [ this, &workers, colours ]( auto &&action )
+		{
+			for ( int colour = 0; colour < colours; colour++ )
+			{
+				int const first = colourStart[ colour ];
+				auto range = [ this, first, &action ]( int begin, int end )
+				{
+					for ( int k = first + begin; k < first + end; k++ )
+						action( coloured[ k ] );
+				};
+
+				int const count = colourStart[ colour + 1 ] - first;
+				if ( colour == maxColours )
+					range( 0, count );
+				else
+					workers.parallelFor( count, range );
+			}
+		};
+
+		forEachColour( [ this ]( Contact &contact ) { prepare( contact ); } );
+
+		int sweep = 0;
+		float largest = 0.f;
+		do
+		{
+			forEachColour( [ this ]( Contact &contact ) { solve( contact ); } );
+			largest = 0.f;
+			for ( Contact const &contact : coloured )
+				largest = std::max( largest, std::abs( contact.change ) );
+			sweep++;
+		} while ( sweep < Params::Stress::solverSweeps && largest > Params::Stress::solverTolerance );
+
+		forEachColour( [ this ]( Contact &contact ) { cacheImpulse( contact ); } );
+		return sweep;
+	}
+
+
+	// sleeping balls set moving by a contact join the awake list
+	void Table::wake()
+	{
+		size_t const before = awake.size();
+		for ( Contact const &contact : contacts )
+		{
+			for ( int ball : { contact.first, contact.second } )
+			{
+				if ( !isAwake[ ball ] && ( speedX[ ball ] != 0.f || speedY[ ball ] != 0.f ) )
+				{
+					isAwake[ ball ] = 1;
+					awake.push_back( ball );
+				}
+			}
+		}
+		if ( awake.size() != before )
+			std::sort( awake.begin(), awake.end() );
+	}
+
+
+	uint64_t Table::checksum() const
+	{
+		// in id order, the storage order doesn't change the hash
+		uint64_t hash = Hashing::mix( uint64_t( size() ) );
+		for ( int id = 0; id < size(); id++ )
+		{
+			int const i = indices[ id ];
+			hash = Hashing::mix( hash ^ ( uint64_t( bitsOf( positionX[ i ] ) ) << 32 | bitsOf( positionY[ i ] ) ) );
+			hash = Hashing::mix( hash ^ ( uint64_t( bitsOf( speedX[ i ] ) ) << 32 | bitsOf( speedY[ i ] ) ) );
+		}
+		return hash;
+	}
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "params.hpp"
+#include "spatial_grid.hpp"
+#include "workers.hpp"
+
+
+//-------------------------------------------------------
+//	Stress test table
+//
+//	Tens of thousands of balls on one table, cushions and
+//	friction as in PhysicTable but no pockets. Ball state is
+//	kept as structure of arrays and every pass runs on
+//	Workers. Balls friction stopped sleep, only the awake
+//	ones move and look for contacts in an incremental grid,
+//	one level per radius class with cells of about a ball
+//	diameter, updated only for the balls that cross a cell
+//	boundary. Contacts are grouped into islands by
+//	union-find and the islands resolved in parallel by
+//	sequential impulses, warm started from a persistent
+//	cache of the impulses each pair took last step; a huge
+//	island is greedily coloured so no ball appears twice in
+//	a colour, a colour is resolved in parallel and the
+//	colours one after another. Islands and colours depend on
+//	the contact order only, never on the threads, so the
+//	result is bit-identical for any worker count. Every few
+//	steps the storage is sorted along a Morton curve so the
+//	passes over neighbours stay within nearby memory.
+//-------------------------------------------------------
+
+namespace Stress
+{
+	struct Contact
+	{
+		int first;
+		int second;
+
+		// solver state along the unit normal from first to second
+		float normalX = 0.f;
+		float normalY = 0.f;
+		float target = 0.f;		// separating speed the contact aims for
+		float impulse = 0.f;	// accumulated this step, warm started from the pair cache
+		float change = 0.f;		// of the impulse in the last sweep
+	};
+
+
+	struct StepStats
+	{
+		int awake = 0;			// balls moving at the start of the step
+		int crossings = 0;		// balls that changed grid cells
+		int contacts = 0;
+		int islands = 0;
+		int colours = 0;		// the most any island split by colours needed
+		int sweeps = 0;			// solver sweeps summed over the islands
+		int droppedPairs = 0;	// pair cache entries of touching pairs lost for want of a slot
+		int64_t contactSpan = 0;	// storage distance between the balls of each contact, summed
+	};
+
+
+	class Table
+	{
+	public:
+		// count balls of Params::Stress::radii, masses by volume, with random speeds, spread without overlaps,
+		// density is the ball area over the table area and stays well under pi / 4
+		void reset( int count = Params::Stress::balls, uint32_t seed = 0, float density = Params::Stress::density );
+
+		StepStats step( Workers &workers );
+
+		// starts every contact from the impulse its pair took last step, on by default
+		void setWarmStarting( bool enabled ) { warmStarting = enabled; }
+		// re-sorts the storage along a Morton curve every interval steps, 0 never does
+		void setReorderInterval( int steps ) { reorderInterval = steps; }
+		// returns the pair cache entries it had no slot for
+		int reorder();
+
+		int size() const { return int( positionX.size() ); }
+		// Balls keep their id for good while reorder() moves them in storage, the arrays
+		// below are indexed by storage index.
+		int indexOf( int id ) const { return indices[ id ]; }
+		int idAt( int index ) const { return ids[ index ]; }
+		float getWidth() const { return width; }
+		float getHeight() const { return height; }
+
+		// hash of every ball's state bits, in id order
+		uint64_t checksum() const;
+
+		std::vector< float > positionX, positionY;
+		std::vector< float > speedX, speedY;
+		std::vector< float > radius;
+		std::vector< float > inverseMass;
+
+	private:
+		void initGrid();
+		int integrate( Workers &workers );
+		void findContacts( Workers &workers );
+		int findRoot( int ball );
+		void findIslands();
+		void prepare( Contact &contact );
+		void solve( Contact &contact );
+		float cachedImpulse( int a, int b ) const;
+		void cacheImpulse( Contact const &contact );
+		int resolveIslands( Workers &workers, int &sweeps );
+		int colourContacts( int begin, int end );
+		int resolveColours( Workers &workers, int colours );
+		void wake();
+
+		float width = 0.f;
+		float height = 0.f;
+
+		std::vector< int > ids;
+		std::vector< int > indices;
+		int reorderInterval = Params::Stress::reorderInterval;
+
+		HierarchicalGrid grid;
+		std::vector< int > sortCursors;		// of the counting sorts by island and colour
+
+		// balls with a speed, in index order
+		std::vector< int > awake;
+		std::vector< uint8_t > isAwake;
+
+		std::vector< std::vector< Contact > > workerContacts;
+		std::vector< Contact > contacts;
+
+		// union-find forest, every ball its own root between steps
+		std::vector< int > parent;
+		std::vector< int > rootIsland;
+		std::vector< int > contactIsland;
+		// contacts sorted by island, island k is islandStart[ k ] .. islandStart[ k + 1 ]
+		std::vector< int > islandStart;
+		std::vector< Contact > islandContacts;
+		std::vector< int > smallIslands;
+		std::vector< int > largeIslands;
+
+		std::vector< int > islandSweeps;
+
+		// Persistent pair cache: a ball of a touching pair keeps the other one and the impulse
+		// the pair took on the step it was last seen. The lower ball does, or the higher one
+		// when that has the staler slot, so a big ball crowded by more than pairSlots, the
+		// kissing number of equal balls, hands pairs to its neighbours. Both balls of a
+		// pair are in one island and only the worker resolving it writes their slots.
+		struct PairSlot
+		{
+			int other = -1;
+			uint32_t step = 0;
+			float impulse = 0.f;
+		};
+		static constexpr int pairSlots = 6;
+		std::vector< std::array< PairSlot, pairSlots > > pairCache;
+		uint32_t stepIndex = 0;
+		bool warmStarting = true;
+		std::atomic< int > droppedPairs { 0 };
+
+		// contacts of one island sorted by colour, colour k is colourStart[ k ] .. colourStart[ k + 1 ]
+		std::vector< uint64_t > usedColours;
+		std::vector< uint8_t > contactColour;
+		std::vector< int > colourStart;
+		std::vector< Contact > coloured;
+	};
+}
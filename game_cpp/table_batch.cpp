@@ -0,0 +1,376 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+#include "table_batch.hpp"
+
+
+namespace
+{
+	// largest squared distance d2 with std::sqrt( d2 ) <= limit, sqrt is correctly
+	// rounded and monotonic so comparing squares against it gives identical answers
+	float squaredLimitInclusive( float limit )
+	{
+		float squared = limit * limit;
+		while ( std::sqrt( squared ) > limit )
+			squared = std::nextafter( squared, 0.f );
+		while ( std::sqrt( std::nextafter( squared, std::numeric_limits< float >::infinity() ) ) <= limit )
+			squared = std::nextafter( squared, std::numeric_limits< float >::infinity() );
+		return squared;
+	}
+
+
+	// smallest squared distance d2 with std::sqrt( d2 ) >= limit, see above
+	float squaredLimitExclusive( float limit )
+	{
+		return std::nextafter( squaredLimitInclusive( std::nextafter( limit, 0.f ) ), std::numeric_limits< float >::infinity() );
+	}
+}
+
+
+TableBatch::TableBatch( int numTables, float* storage ) :
+	numTables( numTables ),
+	stride( strideFor( numTables ) ),
+	pocketSquaredLimit( squaredLimitExclusive( Params::Table::pocketRadius ) ),
+	contactSquaredLimit( squaredLimitInclusive( 2 * Params::Ball::radius ) )
+{
+	assert( numTables > 0 );
+	pocketedMasks.resize( stride, 0 );
+
+	if ( !storage )
+	{
+		ownStorage.resize( storageSize( numTables ) );
+		storage = ownStorage.data();
+	}
+	std::fill_n( storage, storageSize( numTables ), 0.f );
+
+	size_t const array = size_t( numBalls ) * stride;
+	positionX = storage;
+	positionY = storage + array;
+	inGame = storage + 2 * array;
+	speedX = storage + 3 * array;
+	speedY = storage + 4 * array;
+}
+
+
+int TableBatch::size() const
+{
+	return numTables;
+}
+
+
+int TableBatch::index( int ball, int table ) const
+{
+	return ball * stride + table;
+}
+
+
+void TableBatch::load( int table, PhysicTable const &source )
+{
+	assert( table >= 0 && table < numTables );
+	assert( source.isUniform() );
+	for ( int i = 0; i < numBalls; i++ )
+	{
+		positionX[ index( i, table ) ] = source.balls[ i ].getPosition().x;
+		positionY[ index( i, table ) ] = source.balls[ i ].getPosition().y;
+		speedX[ index( i, table ) ] = source.balls[ i ].getSpeed().x;
+		speedY[ index( i, table ) ] = source.balls[ i ].getSpeed().y;
+		inGame[ index( i, table ) ] = source.inGame[ i ] ? 1.f : 0.f;
+	}
+	pocketedMasks[ table ] = 0;
+}
+
+
+void TableBatch::store( int table, PhysicTable &target ) const
+{
+	assert( table >= 0 && table < numTables );
+	for ( int i = 0; i < numBalls; i++ )
+	{
+		target.balls[ i ].setPosition( Vector2( positionX[ index( i, table ) ], positionY[ index( i, table ) ] ) );
+		target.balls[ i ].setSpeed( Vector2( speedX[ index( i, table ) ], speedY[ index( i, table ) ] ) );
+		target.inGame[ i ] = inGame[ index( i, table ) ] != 0.f;
+	}
+}
+
+
+bool TableBatch::strike( int table, Shot const &shot )
+{
+	int const n = index( 0, table );
+	PhysicTable single;
+	single.inGame[ 0 ] = inGame[ n ] != 0.f;
+	single.balls[ 0 ].setSpeed( Vector2( speedX[ n ], speedY[ n ] ) );
+	if ( !single.strike( shot ) )
+		return false;
+
+	speedX[ n ] = single.balls[ 0 ].getSpeed().x;
+	speedY[ n ] = single.balls[ 0 ].getSpeed().y;
+	return true;
+}
+
+
+int TableBatch::inGameMask( int table ) const
+{
+	int mask = 0;
+	for ( int i = 0; i < numBalls; i++ )
+	{
+		if ( inGame[ index( i, table ) ] != 0.f )
+			mask |= 1 << i;
+	}
+	return mask;
+}
+
+
+void TableBatch::step()
+{
+	step( 0, blockCount() );
+}
+
+
+bool TableBatch::isResting() const
+{
+	return isResting( 0, blockCount() );
+}
+
+
+void TableBatch::step( int firstBlock, int endBlock )
+{
+	for ( int block = firstBlock; block < endBlock; block++ )
+	{
+		if ( !isBlockResting( block ) )
+			stepBlock( block );
+	}
+}
+
+
+bool TableBatch::isResting( int firstBlock, int endBlock ) const
+{
+	for ( int block = firstBlock; block < endBlock; block++ )
+	{
+		if ( !isBlockResting( block ) )
+			return false;
+	}
+	return true;
+}
+
+
+bool TableBatch::isResting( int table ) const
+{
+	for ( int i = 0; i < numBalls; i++ )
+	{
+		int const n = index( i, table );
+		if ( inGame[ n ] != 0.f && ( speedX[ n ] != 0.f || speedY[ n ] != 0.f ) )
+			return false;
+	}
+	return true;
+}
+
+
+bool TableBatch::isBlockResting( int block ) const
+{
+	int moving = 0;
+	for ( int i = 0; i < numBalls; i++ )
+	{
+		int const n = index( i, block * laneCount );
+		for ( int lane = 0; lane < laneCount; lane++ )
+			moving |= ( inGame[ n + lane ] != 0.f ) & ( ( speedX[ n + lane ] != 0.f ) | ( speedY[ n + lane ] != 0.f ) );
+	}
+	return moving == 0;
+}
+
+
+inline bool TableBatch::isInPocket( float x, float y, Vector2 pocket ) const
+{
+	float const dx = x - pocket.x;
+	float const dy = y - pocket.y;
+	return dx * dx + dy * dy < pocketSquaredLimit;
+}
+
+
+//-------------------------------------------------------
+//	The lane loops below mirror PhysicTable::step, the
+//	PhysicEvents::ricochet quirks included; every branch of
+//	the scalar code is evaluated and picked with a select.
+//	Each loop is kept free of nested loops and works on
+//	local copies so compilers turn it into vector code
+//	( gcc needs -fno-math-errno -fno-trapping-math for the
+//	selects, neither changes the results ).
+//-------------------------------------------------------
+
+void TableBatch::stepBlock( int block )
+{
+	constexpr float radius = Params::Ball::radius;
+	constexpr float halfWidth = 0.5f * Params::Table::width;
+	constexpr float halfHeight = 0.5f * Params::Table::height;
+	float const friction = Params::Physics::frictionDeceleration;
+	float const stopSpeedSquared = friction * friction * 1.1f;
+
+	int const first = block * laneCount;
+
+	for ( int i = 0; i < numBalls; i++ )
+	{
+		int const n = index( i, first );
+
+		int anyAlive = 0;
+		for ( int lane = 0; lane < laneCount; lane++ )
+			anyAlive |= inGame[ n + lane ] != 0.f;
+		if ( !anyAlive )
+			continue;
+
+		float x[ laneCount ], y[ laneCount ];
+		float sx[ laneCount ], sy[ laneCount ];
+		float speedX0[ laneCount ], speedY0[ laneCount ];
+		float alive[ laneCount ];
+
+		for ( int lane = 0; lane < laneCount; lane++ )
+		{
+			x[ lane ] = positionX[ n + lane ];
+			y[ lane ] = positionY[ n + lane ];
+			speedX0[ lane ] = sx[ lane ] = speedX[ n + lane ];
+			speedY0[ lane ] = sy[ lane ] = speedY[ n + lane ];
+			alive[ lane ] = inGame[ n + lane ];
+		}
+
+		float moveX[ laneCount ], moveY[ laneCount ];
+		float revertX[ laneCount ], revertY[ laneCount ];
+		float live[ laneCount ], dropped[ laneCount ];
+		for ( int lane = 0; lane < laneCount; lane++ )
+		{
+			float const nx = x[ lane ] + sx[ lane ];
+			float const ny = y[ lane ] + sy[ lane ];
+
+			// pockets
+			bool const pocketed =
+				isInPocket( nx, ny, Params::Table::pocketsPositions[ 0 ] ) |
+				isInPocket( nx, ny, Params::Table::pocketsPositions[ 1 ] ) |
+				isInPocket( nx, ny, Params::Table::pocketsPositions[ 2 ] ) |
+				isInPocket( nx, ny, Params::Table::pocketsPositions[ 3 ] ) |
+				isInPocket( nx, ny, Params::Table::pocketsPositions[ 4 ] ) |
+				isInPocket( nx, ny, Params::Table::pocketsPositions[ 5 ] );
+			bool const isAlive = alive[ lane ] != 0.f;
+			live[ lane ] = isAlive & !pocketed ? 1.f : 0.f;
+			dropped[ lane ] = isAlive & pocketed ? 1.f : 0.f;
+
+			// friction
+			float vx = sx[ lane ];
+			float vy = sy[ lane ];
+			float const length = std::sqrt( vx * vx + vy * vy );
+			float const slowX = vx + -( vx / length ) * friction;
+			float const slowY = vy + -( vy / length ) * friction;
+			bool const stops = ( vx * vx + vy * vy ) <= stopSpeedSquared;
+			bool const moving = ( vx != 0 ) | ( vy != 0 );
+			float const frictionX = stops ? 0.f : slowX;
+			float const frictionY = stops ? 0.f : slowY;
+			vx = moving ? frictionX : vx;
+			vy = moving ? frictionY : vy;
+
+			// cushions
+			float rx = nx;
+			float ry = ny;
+			bool const right = nx + radius > halfWidth;
+			rx = right ? nx - ( nx + radius - halfWidth ) * 2 : rx;
+			vx = right ? -vx : vx;
+			bool const left = rx - radius < -halfWidth;
+			rx = left ? nx + ( -halfWidth - nx + radius ) * 2 : rx;
+			vx = left ? -vx : vx;
+			bool const top = ny + radius > halfHeight;
+			ry = top ? ny - ( ny + radius - halfHeight ) * 2 : ry;
+			rx = top ? nx : rx;
+			vy = top ? -vy : vy;
+			bool const bottom = ry - radius < -halfHeight;
+			ry = bottom ? ny + ( -halfHeight - ny + radius ) * 2 : ry;
+			rx = bottom ? nx : rx;
+			vy = bottom ? -vy : vy;
+
+			bool const cushion = right | ( nx - radius < -halfWidth ) | top | ( ny - radius < -halfHeight );
+			moveX[ lane ] = rx;
+			moveY[ lane ] = ry;
+			revertX[ lane ] = cushion ? rx : x[ lane ];
+			revertY[ lane ] = cushion ? ry : y[ lane ];
+			sx[ lane ] = vx;
+			sy[ lane ] = vy;
+		}
+
+		// the fixed ball pairs ( i, l > i )
+		for ( int l = i + 1; l < numBalls; l++ )
+		{
+			int const m = index( l, first );
+
+			// contacts are rare, the response is only evaluated when some lane has one
+			float hit[ laneCount ];
+			int anyHit = 0;
+			for ( int lane = 0; lane < laneCount; lane++ )
+			{
+				float const dx = moveX[ lane ] - positionX[ m + lane ];
+				float const dy = moveY[ lane ] - positionY[ m + lane ];
+				bool const contact = ( live[ lane ] != 0.f ) & ( inGame[ m + lane ] != 0.f ) & ( dx * dx + dy * dy <= contactSquaredLimit );
+				hit[ lane ] = contact ? 1.f : 0.f;
+				anyHit |= contact;
+			}
+			if ( !anyHit )
+				continue;
+
+			float otherX[ laneCount ], otherY[ laneCount ];
+			float otherSpeedX[ laneCount ], otherSpeedY[ laneCount ];
+			for ( int lane = 0; lane < laneCount; lane++ )
+			{
+				otherX[ lane ] = positionX[ m + lane ];
+				otherY[ lane ] = positionY[ m + lane ];
+				otherSpeedX[ lane ] = speedX[ m + lane ];
+				otherSpeedY[ lane ] = speedY[ m + lane ];
+			}
+
+			for ( int lane = 0; lane < laneCount; lane++ )
+			{
+				float const gx = otherX[ lane ] - revertX[ lane ];
+				float const gy = otherY[ lane ] - revertY[ lane ];
+				float const length = std::sqrt( gx * gx + gy * gy );
+				float const tx = gx / length;
+				float const ty = gy / length;
+				float const pr1 = ( sx[ lane ] * gx + sy[ lane ] * gy ) / length;
+				float const pr2 = ( otherSpeedX[ lane ] * gx + otherSpeedY[ lane ] * gy ) / length;
+				float const g1x = tx * pr1, g1y = ty * pr1;
+				float const g2x = tx * pr2, g2y = ty * pr2;
+
+				float const speed1X = sx[ lane ] - g1x + g2x;
+				float const speed1Y = sy[ lane ] - g1y + g2y;
+				float const speed2X = otherSpeedX[ lane ] + g1x - g2x;
+				float const speed2Y = otherSpeedY[ lane ] + g1y - g2y;
+
+				bool const contact = hit[ lane ] != 0.f;
+				moveX[ lane ] = contact ? revertX[ lane ] : moveX[ lane ];
+				moveY[ lane ] = contact ? revertY[ lane ] : moveY[ lane ];
+				sx[ lane ] = contact ? speed1X : sx[ lane ];
+				sy[ lane ] = contact ? speed1Y : sy[ lane ];
+				otherSpeedX[ lane ] = contact ? speed2X : otherSpeedX[ lane ];
+				otherSpeedY[ lane ] = contact ? speed2Y : otherSpeedY[ lane ];
+			}
+
+			for ( int lane = 0; lane < laneCount; lane++ )
+			{
+				speedX[ m + lane ] = otherSpeedX[ lane ];
+				speedY[ m + lane ] = otherSpeedY[ lane ];
+			}
+		}
+
+		for ( int lane = 0; lane < laneCount; lane++ )
+		{
+			bool const moves = live[ lane ] != 0.f;
+			alive[ lane ] = dropped[ lane ] != 0.f ? 0.f : alive[ lane ];
+			x[ lane ] = moves ? moveX[ lane ] : x[ lane ];
+			y[ lane ] = moves ? moveY[ lane ] : y[ lane ];
+			speedX0[ lane ] = moves ? sx[ lane ] : speedX0[ lane ];
+			speedY0[ lane ] = moves ? sy[ lane ] : speedY0[ lane ];
+		}
+
+		for ( int lane = 0; lane < laneCount; lane++ )
+		{
+			positionX[ n + lane ] = x[ lane ];
+			positionY[ n + lane ] = y[ lane ];
+			speedX[ n + lane ] = speedX0[ lane ];
+			speedY[ n + lane ] = speedY0[ lane ];
+			inGame[ n + lane ] = alive[ lane ];
+			pocketedMasks[ first + lane ] |= dropped[ lane ] != 0.f ? 1 << i : 0;
+		}
+	}
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <vector>
+
+#include "physics.hpp"
+
+
+//-------------------------------------------------------
+//	Batch of tables stepped one vector lane per table
+//
+//	State is stored transposed: each array holds one ball
+//	slot for every table, so lane n of a vector is table n.
+//	Tables are processed in blocks of laneCount, every block
+//	runs the same branch free sequence of operations as
+//	PhysicTable::step, so results match the scalar code
+//	bit for bit as long as the compiler doesn't contract
+//	floating point expressions.
+//	The state can live in memory the caller provides, the
+//	shared memory env steps it in place that way.
+//-------------------------------------------------------
+
+class TableBatch
+{
+public:
+	static constexpr int laneCount = 16;
+	static constexpr int numBalls = PhysicTable::numBalls;
+
+	// Storage, if given, holds storageSize( numTables ) floats: positionX, positionY,
+	// inGame, speedX and speedY, each numBalls rows of strideFor( numTables ) tables.
+	explicit TableBatch( int numTables, float* storage = nullptr );
+	TableBatch( TableBatch const& ) = delete;
+
+	static int strideFor( int numTables ) { return ( numTables + laneCount - 1 ) / laneCount * laneCount; }
+	static size_t storageSize( int numTables ) { return size_t( 5 ) * numBalls * strideFor( numTables ); }
+
+	int size() const;
+
+	// uniform tables only, the batch runs the standard step
+	void load( int table, PhysicTable const &source );
+	void store( int table, PhysicTable &target ) const;
+
+	// the same as PhysicTable::strike on the table
+	bool strike( int table, Shot const &shot );
+	int inGameMask( int table ) const;
+
+	// advances every block that still has moving balls, ORs pocketed balls into pocketedMasks
+	void step();
+	bool isResting() const;
+	bool isResting( int table ) const;
+
+	// Blocks of laneCount tables share nothing, so ranges of them can be stepped on
+	// different threads, each range at its own pace.
+	int blockCount() const { return stride / laneCount; }
+	void step( int firstBlock, int endBlock );
+	bool isResting( int firstBlock, int endBlock ) const;
+
+	std::vector< int > pocketedMasks;
+
+private:
+	int index( int ball, int table ) const;
+	void stepBlock( int block );
+	bool isBlockResting( int block ) const;
+	bool isInPocket( float x, float y, Vector2 pocket ) const;
+
+	int numTables = 0;
+	int stride = 0;
+
+	// squared distance limits equivalent to the sqrt based tests of the scalar code
+	float pocketSquaredLimit = 0.f;
+	float contactSquaredLimit = 0.f;
+
+	std::vector< float > ownStorage;
+	float* positionX = nullptr;
+	float* positionY = nullptr;
+	float* inGame = nullptr;
+	float* speedX = nullptr;
+	float* speedY = nullptr;
+};
@@ -0,0 +1,294 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "hashing.hpp"
+#include "transposition.hpp"
+
+
+namespace Transposition
+{
+	namespace
+	{
+		constexpr float twoPi = 6.28318531f;
+
+		enum class Feature : uint64_t
+		{
+			ball = 1,
+			pocketed = 2,
+			angle = 3,
+			power = 4,
+			size = 5
+		};
+
+		// distinct features pack to distinct words and mix is a bijection, so keys never repeat
+		uint64_t featureKey( Feature feature, int slot, int a, int b )
+		{
+			uint64_t const packed = ( uint64_t( feature ) << 60 ) | ( uint64_t( slot & 0xF ) << 56 ) |
+				( uint64_t( uint32_t( a ) & 0xFFFFFF ) << 24 ) | uint64_t( uint32_t( b ) & 0xFFFFFF );
+			return Hashing::mix( packed );
+		}
+
+		// entries pack positions only, the balls keep the sizes they had before the shot
+		Shots::Outcome withSizes( Shots::Outcome outcome, PhysicTable const &table )
+		{
+			for ( int i = 0; i < PhysicTable::numBalls; i++ )
+			{
+				outcome.table.balls[ i ].setRadius( table.balls[ i ].getRadius() );
+				outcome.table.balls[ i ].setMass( table.balls[ i ].getMass() );
+			}
+			return outcome;
+		}
+
+		// packed outcome layout, 16 bit fields
+		constexpr int maskField = 2 * PhysicTable::numBalls;
+		constexpr int stepsField = maskField + 1;
+		constexpr uint16_t validBit = 0x8000;
+	}
+
+
+	uint64_t ballKey( int slot, int cellX, int cellY )
+	{
+		return featureKey( Feature::ball, slot, cellX, cellY );
+	}
+
+
+	uint64_t pocketedKey( int slot )
+	{
+		return featureKey( Feature::pocketed, slot, 0, 0 );
+	}
+
+
+	uint64_t sizeKey( int slot, float radius, float mass )
+	{
+		uint32_t radiusBits, massBits;
+		std::memcpy( &radiusBits, &radius, sizeof( radiusBits ) );
+		std::memcpy( &massBits, &mass, sizeof( massBits ) );
+		return Hashing::mix( featureKey( Feature::size, slot, 0, 0 ) ^ ( ( uint64_t( radiusBits ) << 32 ) | massBits ) );
+	}
+
+
+	uint64_t angleKey( int step )
+	{
+		return featureKey( Feature::angle, 0, step, 0 );
+	}
+
+
+	uint64_t powerKey( int step )
+	{
+		return featureKey( Feature::power, 0, step, 0 );
+	}
+
+
+	int positionCell( float coordinate )
+	{
+		long const cell = std::lround( coordinate / Params::Transposition::positionCell );
+		return int( std::max( std::min( cell, long( INT16_MAX ) ), long( INT16_MIN ) ) );
+	}
+
+
+	int angleStep( Vector2 direction )
+	{
+		float const angle = std::atan2( direction.y, direction.x );
+		int const step = int( std::lround( angle / twoPi * Params::Transposition::angleSteps ) );
+		return ( step + Params::Transposition::angleSteps ) % Params::Transposition::angleSteps;
+	}
+
+
+	int powerStep( float power )
+	{
+		float const clamped = std::max( std::min( power, 1.f ), 0.f );
+		return int( std::lround( clamped * Params::Transposition::powerSteps ) );
+	}
+
+
+	uint64_t tableKey( PhysicTable const &table )
+	{
+		uint64_t key = 0;
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		{
+			if ( table.inGame[ i ] )
+			{
+				Vector2 const position = table.balls[ i ].getPosition();
+				key ^= ballKey( i, positionCell( position.x ), positionCell( position.y ) );
+			}
+			else
+				key ^= pocketedKey( i );
+
+			// a standard ball adds nothing, so keys of the standard rack stay as they were
+			BillBall const &ball = table.balls[ i ];
+			if ( ball.getRadius() != Params::Ball::radius || ball.getMass() != Params::Ball::mass )
+				key ^= sizeKey( i, ball.getRadius(), ball.getMass() );
+		}
+		return key;
+	}
+
+
+	uint64_t shotKey( Shot const &shot )
+	{
+		return angleKey( angleStep( shot.direction ) ) ^ powerKey( powerStep( shot.power ) );
+	}
+
+
+	PhysicTable snapped( PhysicTable const &table )
+	{
+		PhysicTable result;
+		result.inGame = table.inGame;
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		{
+			result.balls[ i ].setRadius( table.balls[ i ].getRadius() );
+			result.balls[ i ].setMass( table.balls[ i ].getMass() );
+			Vector2 const position = table.balls[ i ].getPosition();
+			result.balls[ i ].setPosition( Vector2( positionCell( position.x ) * Params::Transposition::positionCell,
+				positionCell( position.y ) * Params::Transposition::positionCell ) );
+		}
+		return result;
+	}
+
+
+	Shot snapped( Shot const &shot )
+	{
+		float const angle = angleStep( shot.direction ) * twoPi / Params::Transposition::angleSteps;
+
+		Shot result;
+		result.direction = Vector2( std::cos( angle ), std::sin( angle ) );
+		result.power = float( powerStep( shot.power ) ) / Params::Transposition::powerSteps;
+		return result;
+	}
+
+
+	//-------------------------------------------------------
+	//	Fixed size lock free cache
+	//-------------------------------------------------------
+
+	Cache::Cache( int sizeLog2 )
+		: entries( new Entry[ size_t( 1 ) << sizeLog2 ] )
+		, mask( ( size_t( 1 ) << sizeLog2 ) - 1 )
+	{
+	}
+
+
+	bool Cache::find( uint64_t key, Shots::Outcome &outcome ) const
+	{
+		Entry const &entry = entries[ key & mask ];
+
+		uint64_t const check = entry.check.load( std::memory_order_acquire );
+		Packed packed;
+		for ( int i = 0; i < packedWords; i++ )
+			packed[ i ] = entry.words[ i ].load( std::memory_order_relaxed );
+
+		if ( check != seal( key, packed ) )
+			return false;
+
+		uint16_t fields[ 4 * packedWords ];
+		std::memcpy( fields, packed.data(), sizeof( fields ) );
+		if ( !( fields[ maskField ] & validBit ) )
+			return false;
+
+		outcome = unpack( packed );
+		return true;
+	}
+
+
+	void Cache::store( uint64_t key, Shots::Outcome const &outcome )
+	{
+		Entry &entry = entries[ key & mask ];
+
+		Packed const packed = pack( outcome );
+		for ( int i = 0; i < packedWords; i++ )
+			entry.words[ i ].store( packed[ i ], std::memory_order_relaxed );
+		entry.check.store( seal( key, packed ), std::memory_order_release );
+	}
+
+
+	void Cache::clear()
+	{
+		for ( size_t i = 0; i <= mask; i++ )
+		{
+			entries[ i ].check.store( 0, std::memory_order_relaxed );
+			for ( std::atomic< uint64_t > &word : entries[ i ].words )
+				word.store( 0, std::memory_order_relaxed );
+		}
+	}
+
+
+	Shots::Outcome Cache::quantised( Shots::Outcome const &outcome )
+	{
+		return unpack( pack( outcome ) );
+	}
+
+
+	Cache::Packed Cache::pack( Shots::Outcome const &outcome )
+	{
+		static_assert( stepsField < 4 * packedWords, "the outcome doesn't fit the entry" );
+
+		uint16_t fields[ 4 * packedWords ] = {};
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		{
+			if ( !outcome.table.inGame[ i ] )
+				continue;
+			Vector2 const position = outcome.table.balls[ i ].getPosition();
+			fields[ 2 * i ] = uint16_t( int16_t( positionCell( position.x ) ) );
+			fields[ 2 * i + 1 ] = uint16_t( int16_t( positionCell( position.y ) ) );
+		}
+		fields[ maskField ] = uint16_t( validBit | outcome.table.inGameMask() | ( outcome.pocketedMask << PhysicTable::numBalls ) );
+		fields[ stepsField ] = uint16_t( std::min( outcome.steps, int( UINT16_MAX ) ) );
+
+		Packed packed;
+		std::memcpy( packed.data(), fields, sizeof( fields ) );
+		return packed;
+	}
+
+
+	Shots::Outcome Cache::unpack( Packed const &packed )
+	{
+		uint16_t fields[ 4 * packedWords ];
+		std::memcpy( fields, packed.data(), sizeof( fields ) );
+
+		int const ballsMask = ( 1 << PhysicTable::numBalls ) - 1;
+
+		Shots::Outcome outcome;
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		{
+			outcome.table.inGame[ i ] = ( fields[ maskField ] & ( 1 << i ) ) != 0;
+			outcome.table.balls[ i ].setPosition( Vector2( int16_t( fields[ 2 * i ] ) * Params::Transposition::positionCell,
+				int16_t( fields[ 2 * i + 1 ] ) * Params::Transposition::positionCell ) );
+		}
+		outcome.pocketedMask = ( fields[ maskField ] >> PhysicTable::numBalls ) & ballsMask;
+		outcome.steps = fields[ stepsField ];
+		outcome.elapsed = float( outcome.steps );
+		outcome.settled = true;
+		return outcome;
+	}
+
+
+	uint64_t Cache::seal( uint64_t key, Packed const &packed )
+	{
+		uint64_t check = key;
+		for ( uint64_t word : packed )
+			check = Hashing::mix( check ^ word );
+		return check;
+	}
+
+
+	//-------------------------------------------------------
+	//	Cached shot simulation
+	//-------------------------------------------------------
+
+	Shots::Outcome play( Cache &cache, PhysicTable const &table, Shot const &shot, int maxSteps )
+	{
+		uint64_t const key = tableKey( table ) ^ shotKey( shot );
+
+		// entries only hold settled shots, one that needed more steps than allowed here is a miss
+		Shots::Outcome outcome;
+		if ( cache.find( key, outcome ) && outcome.steps <= maxSteps )
+			return withSizes( outcome, table );
+
+		outcome = Shots::play( snapped( table ), snapped( shot ), maxSteps );
+		if ( !outcome.settled )
+			return outcome;
+
+		cache.store( key, outcome );
+		return withSizes( Cache::quantised( outcome ), table );
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "physics.hpp"
+#include "shots.hpp"
+
+
+//-------------------------------------------------------
+//	Transposition cache of shot outcomes
+//
+//	Keys are Zobrist hashes: every quantised feature ( a ball
+//	slot in a position cell, a pocketed slot, the size of a
+//	ball off the standard, a shot angle or power step ) owns
+//	a pseudo random 64 bit key and a query key is the xor of
+//	its features' keys, so moving one ball updates a key with
+//	two xors. Speeds aren't part of the key, it describes a
+//	table at rest.
+//
+//	Outcomes are simulated from the snapped table and shot
+//	and stored with positions on the same grid, so a hit and
+//	a miss return exactly the same outcome and planners stay
+//	deterministic whatever the thread timing. Shots that
+//	don't settle within maxSteps are returned but not cached.
+//	Radii and masses aren't stored, an outcome's balls keep
+//	those of the table the shot was played on.
+//-------------------------------------------------------
+
+namespace Transposition
+{
+	uint64_t ballKey( int slot, int cellX, int cellY );
+	uint64_t pocketedKey( int slot );
+	// only for balls off Params::Ball::radius or Params::Ball::mass
+	uint64_t sizeKey( int slot, float radius, float mass );
+	uint64_t angleKey( int step );
+	uint64_t powerKey( int step );
+
+	int positionCell( float coordinate );
+	int angleStep( Vector2 direction );
+	int powerStep( float power );
+
+	uint64_t tableKey( PhysicTable const &table );
+	uint64_t shotKey( Shot const &shot );
+
+	// resting table and shot moved to the centres of their cells
+	PhysicTable snapped( PhysicTable const &table );
+	Shot snapped( Shot const &shot );
+
+
+	//-------------------------------------------------------
+	//	Fixed size lock free cache
+	//
+	//	Each entry holds the packed outcome and a check word,
+	//	the key sealed with the packed words. Writers store the
+	//	words then the check and always replace, readers load
+	//	both and accept the entry only if the check verifies,
+	//	so a torn entry written concurrently reads as a miss.
+	//-------------------------------------------------------
+
+	class Cache
+	{
+	public:
+		explicit Cache( int sizeLog2 = Params::Transposition::cacheSizeLog2 );
+		Cache( Cache const& ) = delete;
+
+		bool find( uint64_t key, Shots::Outcome &outcome ) const;
+		void store( uint64_t key, Shots::Outcome const &outcome );
+		void clear();
+
+		// the outcome as find would return it after store
+		static Shots::Outcome quantised( Shots::Outcome const &outcome );
+
+		size_t size() const { return mask + 1; }
+
+	private:
+		static constexpr int packedWords = 4;
+		using Packed = std::array< uint64_t, packedWords >;
+
+		struct alignas( 64 ) Entry
+		{
+			std::atomic< uint64_t > check { 0 };
+			std::array< std::atomic< uint64_t >, packedWords > words {};
+		};
+
+		static Packed pack( Shots::Outcome const &outcome );
+		static Shots::Outcome unpack( Packed const &packed );
+		static uint64_t seal( uint64_t key, Packed const &packed );
+
+		std::unique_ptr< Entry[] > entries;
+		size_t mask = 0;
+	};
+
+
+	// looks the shot up and simulates it on a miss
+	Shots::Outcome play( Cache &cache, PhysicTable const &table, Shot const &shot, int maxSteps = Params::Env::maxShotSteps );
+}
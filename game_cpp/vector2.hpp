@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cmath>
+
+
+//-------------------------------------------------------
+//	Basic Vector2 class
+//-------------------------------------------------------
+
+class Vector2
+{
+public:
+	float x = 0.f;
+	float y = 0.f;
+
+	constexpr Vector2() = default;
+	constexpr Vector2( float vx, float vy );
+	constexpr Vector2( Vector2 const &other ) = default;
+	Vector2 &operator=( Vector2 const &other ) = default;
+};
+
+
+constexpr Vector2::Vector2( float vx, float vy ) :
+	x( vx ),
+	y( vy )
+{
+}
+
+inline Vector2 normalizedVector(Vector2 v)
+{
+    float vectorLength = std::sqrt(v.x * v.x + v.y * v.y);
+    Vector2 newVector(v.x / vectorLength, v.y / vectorLength);
+
+    return newVector;
+}
+
+inline float distance(Vector2 v1, Vector2 v2)
+{
+    return std::sqrt( (v1.x-v2.x)*(v1.x-v2.x) + (v1.y-v2.y)*(v1.y-v2.y) );
+}
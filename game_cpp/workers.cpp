@@ -0,0 +1,66 @@
+#include <algorithm>
+
+#include "workers.hpp"
+
+
+Workers::Workers( int threads )
+{
+	if ( threads <= 0 )
+		threads = int( std::max( std::thread::hardware_concurrency(), 1u ) );
+	for ( int i = 1; i < threads; i++ )
+		this->threads.emplace_back( &Workers::loop, this, i );
+}
+
+
+Workers::~Workers()
+{
+	{
+		std::lock_guard< std::mutex > lock( mutex );
+		stopping = true;
+	}
+	started.notify_all();
+	for ( std::thread &thread : threads )
+		thread.join();
+}
+
+
+void Workers::run( std::function< void( int ) > const &job )
+{
+	{
+		std::lock_guard< std::mutex > lock( mutex );
+		current = &job;
+		running = int( threads.size() );
+		generation++;
+	}
+	started.notify_all();
+
+	job( 0 );
+
+	std::unique_lock< std::mutex > lock( mutex );
+	finished.wait( lock, [ this ] { return running == 0; } );
+	current = nullptr;
+}
+
+
+void Workers::loop( int worker )
+{
+	uint64_t seen = 0;
+	for ( ;; )
+	{
+		std::function< void( int ) > const* job = nullptr;
+		{
+			std::unique_lock< std::mutex > lock( mutex );
+			started.wait( lock, [ & ] { return stopping || generation != seen; } );
+			if ( stopping )
+				return;
+			seen = generation;
+			job = current;
+		}
+
+		( *job )( worker );
+
+		std::lock_guard< std::mutex > lock( mutex );
+		if ( --running == 0 )
+			finished.notify_one();
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//-------------------------------------------------------
+//	Persistent worker threads
+//
+//	For work split many times a frame, where starting
+//	threads every time would cost more than the work. The
+//	calling thread is worker 0 and takes its share too.
+//-------------------------------------------------------
+
+class Workers
+{
+public:
+	// 0 threads means one per hardware thread
+	explicit Workers( int threads = 0 );
+	Workers( Workers const& ) = delete;
+	~Workers();
+
+	int count() const { return int( threads.size() ) + 1; }
+
+	// job( worker ) on every worker, returns when all are done
+	void run( std::function< void( int ) > const &job );
+
+	// task( begin, end ) on contiguous ranges covering [ 0, size ), one per worker in order
+	template< typename Task >
+	void parallelFor( int size, Task &&task );
+
+private:
+	void loop( int worker );
+
+	std::vector< std::thread > threads;
+	std::mutex mutex;
+	std::condition_variable started;
+	std::condition_variable finished;
+	std::function< void( int ) > const* current = nullptr;
+	uint64_t generation = 0;
+	int running = 0;
+	bool stopping = false;
+};
+
+
+template< typename Task >
+void Workers::parallelFor( int size, Task &&task )
+{
+	int const workers = count();
+	if ( workers == 1 || size < 2 )
+	{
+		task( 0, size );
+		return;
+	}
+
+	run( [ & ]( int worker )
+	{
+		int const begin = int( int64_t( size ) * worker / workers );
+		int const end = int( int64_t( size ) * ( worker + 1 ) / workers );
+		if ( begin < end )
+			task( begin, end );
+	} );
+}
@@ -0,0 +1,93 @@
+//-------------------------------------------------------
+//	Regression check of TableBatch against PhysicTable::step:
+//	random break shots on many tables, both stepped side by
+//	side and compared bit for bit after every step. Returns
+//	non zero on the first mismatch.
+//
+//	build: g++ -std=c++17 -O2 -ffp-contract=off -fno-math-errno -fno-trapping-math
+//	       tools/batch_check.cpp game_cpp/table_batch.cpp game_cpp/physics.cpp game_cpp/prediction.cpp
+//-------------------------------------------------------
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../game_cpp/random.hpp"
+#include "../game_cpp/table_batch.hpp"
+
+
+namespace
+{
+	bool sameBits( float a, float b )
+	{
+		uint32_t x, y;
+		std::memcpy( &x, &a, sizeof( x ) );
+		std::memcpy( &y, &b, sizeof( y ) );
+		return x == y;
+	}
+
+
+	bool sameTable( PhysicTable const &a, PhysicTable const &b )
+	{
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		{
+			if ( a.inGame[ i ] != b.inGame[ i ] ||
+				!sameBits( a.balls[ i ].getPosition().x, b.balls[ i ].getPosition().x ) ||
+				!sameBits( a.balls[ i ].getPosition().y, b.balls[ i ].getPosition().y ) ||
+				!sameBits( a.balls[ i ].getSpeed().x, b.balls[ i ].getSpeed().x ) ||
+				!sameBits( a.balls[ i ].getSpeed().y, b.balls[ i ].getSpeed().y ) )
+				return false;
+		}
+		return true;
+	}
+}
+
+
+int main( int argc, char* argv[] )
+{
+	int const tables = argc > 1 ? std::atoi( argv[ 1 ] ) : 3000;
+	int const steps = argc > 2 ? std::atoi( argv[ 2 ] ) : 2000;
+	if ( tables <= 0 || steps <= 0 )
+	{
+		std::printf( "usage: batch_check [ tables [ steps ] ]\n" );
+		return 2;
+	}
+
+	std::vector< PhysicTable > scalar( tables );
+	std::vector< int > scalarPocketed( tables, 0 );
+	TableBatch batch( tables );
+	for ( int e = 0; e < tables; e++ )
+	{
+		Random::Stream stream( uint32_t( e ), 0, Random::Purpose::noise );
+		Shot shot;
+		shot.direction = Vector2( stream.uniform( -1.f, 1.f ), stream.uniform( -1.f, 1.f ) );
+		shot.power = stream.uniform( 0.05f, 1.f );
+
+		scalar[ e ].reset();
+		scalar[ e ].strike( shot );
+		batch.load( e, scalar[ e ] );
+	}
+
+	PhysicTable stored;
+	for ( int step = 0; step < steps; step++ )
+	{
+		for ( int e = 0; e < tables; e++ )
+			scalarPocketed[ e ] |= scalar[ e ].step();
+		batch.step();
+
+		for ( int e = 0; e < tables; e++ )
+		{
+			batch.store( e, stored );
+			if ( !sameTable( stored, scalar[ e ] ) || batch.pocketedMasks[ e ] != scalarPocketed[ e ] )
+			{
+				std::printf( "mismatch: table %d after step %d\n", e, step + 1 );
+				return 1;
+			}
+		}
+	}
+
+	std::printf( "batch matches the scalar step: %d tables, %d steps\n", tables, steps );
+	return 0;
+}
@@ -0,0 +1,44 @@
+#!/bin/sh
+#-------------------------------------------------------
+#	Builds the headless parts with g++ and runs the
+#	regression checks, CI runs it on every push.
+#
+#	libminibill_env.so	training env C interface
+#	checksum_diff		compares two --checksums streams
+#	batch_check			TableBatch against PhysicTable::step
+#	shots_check			early exit shot questions against full runs
+#	screening_check		coarse screening tier against the full simulation
+#	prediction_check	closed form rest and event free steps against stepping
+#	mixed_check			mixed ball path against the uniform one and on the mixed rack
+#	replay_check		replay seeks against the recorded tables, cut files included
+#	substep_check		substeps catch the grazes the base step jumps over
+#
+#	usage: tools/build.sh [ output directory, build by default ]
+#-------------------------------------------------------
+
+set -e
+cd "$( dirname "$0" )/.."
+out=${1:-build}
+mkdir -p "$out"
+
+flags="-std=c++17 -O2 -Wall -fno-math-errno -fno-trapping-math -ffp-contract=off -pthread"
+headless=$( ls game_cpp/*.cpp | grep -v -e '/main\.cpp$' -e '/game\.cpp$' )
+physics="game_cpp/physics.cpp game_cpp/prediction.cpp"
+
+g++ $flags -shared -fPIC -fvisibility=hidden -DMINIBILL_ENV_EXPORTS $headless -o "$out/libminibill_env.so"
+g++ $flags tools/checksum_diff.cpp game_cpp/checksum.cpp $physics -o "$out/checksum_diff"
+g++ $flags tools/batch_check.cpp game_cpp/table_batch.cpp $physics -o "$out/batch_check"
+g++ $flags tools/shots_check.cpp game_cpp/shots.cpp game_cpp/pocketability.cpp $physics -o "$out/shots_check"
+g++ $flags tools/screening_check.cpp game_cpp/screening.cpp game_cpp/shots.cpp game_cpp/pocketability.cpp $physics -o "$out/screening_check"
+g++ $flags tools/prediction_check.cpp game_cpp/shots.cpp game_cpp/pocketability.cpp $physics -o "$out/prediction_check"
+g++ $flags tools/mixed_check.cpp game_cpp/shots.cpp game_cpp/pocketability.cpp $physics -o "$out/mixed_check"
+g++ $flags tools/substep_check.cpp game_cpp/shots.cpp game_cpp/pocketability.cpp $physics -o "$out/substep_check"
+g++ $flags tools/replay_check.cpp game_cpp/replay.cpp game_cpp/shots.cpp game_cpp/pocketability.cpp $physics -o "$out/replay_check"
+
+"$out/batch_check"
+"$out/shots_check"
+"$out/screening_check"
+"$out/prediction_check"
+"$out/mixed_check"
+"$out/replay_check" "$out/replay_check.bin"
+"$out/substep_check"
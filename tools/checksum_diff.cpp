@@ -0,0 +1,82 @@
+//-------------------------------------------------------
+//	Compares two checksum streams written with
+//	minibill --checksums <file> and reports the first frame
+//	and ball slot where the runs diverge. Restarts split the
+//	streams into rounds, frames pair up within a round.
+//
+//	build: g++ -std=c++17 tools/checksum_diff.cpp game_cpp/checksum.cpp game_cpp/physics.cpp
+//	       game_cpp/prediction.cpp
+//-------------------------------------------------------
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include "../game_cpp/checksum.hpp"
+
+
+int main( int argc, char* argv[] )
+{
+	if ( argc != 3 )
+	{
+		std::printf( "usage: checksum_diff <first stream> <second stream>\n" );
+		return 2;
+	}
+
+	std::ifstream first( argv[ 1 ] );
+	std::ifstream second( argv[ 2 ] );
+	if ( !first || !second )
+	{
+		std::printf( "can't open %s\n", !first ? argv[ 1 ] : argv[ 2 ] );
+		return 2;
+	}
+
+	Checksum::Frame a, b;
+	unsigned long long frames = 0;
+	int round = 0;
+	while ( true )
+	{
+		Checksum::Record const recordA = Checksum::read( first, a );
+		Checksum::Record const recordB = Checksum::read( second, b );
+		if ( recordA != recordB )
+		{
+			if ( recordA == Checksum::Record::end || recordB == Checksum::Record::end )
+				std::printf( "streams agree for %llu frames, then %s ends\n", frames, recordA == Checksum::Record::end ? argv[ 1 ] : argv[ 2 ] );
+			else
+				std::printf( "streams agree for %llu frames, then %s restarts in round %d\n", frames, recordA == Checksum::Record::reset ? argv[ 1 ] : argv[ 2 ], round );
+			return 1;
+		}
+		if ( recordA == Checksum::Record::end )
+		{
+			std::printf( "streams match, %llu frames over %d rounds\n", frames, std::max( round, 1 ) );
+			return 0;
+		}
+		if ( recordA == Checksum::Record::reset )
+		{
+			round++;
+			continue;
+		}
+
+		if ( a.frame != b.frame || a.table != b.table )
+		{
+			std::printf( "first divergent frame: %u of round %d", a.frame, std::max( round, 1 ) );
+			if ( a.frame != b.frame )
+				std::printf( " ( numbered %u in %s, streams are misaligned )", b.frame, argv[ 2 ] );
+			std::printf( "\n" );
+
+			bool anyBall = false;
+			for ( int i = 0; i < PhysicTable::numBalls; i++ )
+			{
+				if ( a.balls[ i ] != b.balls[ i ] )
+				{
+					std::printf( "%s ball %d\n", anyBall ? "    and" : "  first divergent:", i );
+					anyBall = true;
+				}
+			}
+			if ( !anyBall )
+				std::printf( "  ball states agree, histories diverged earlier or the streams start differently\n" );
+			return 1;
+		}
+		frames++;
+	}
+}
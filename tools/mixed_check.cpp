@@ -0,0 +1,196 @@
+//-------------------------------------------------------
+//	Check of the mixed ball path:
+//
+//	- on the standard rack PhysicStep::Mixed must follow
+//	  PhysicStep::Standard: the same collision within float
+//	  rounding, bit for bit until the first contact and the
+//	  same pocketed balls on almost every shot, the break
+//	  amplifies the rounding after that;
+//	- on unequal balls a collision keeps momentum and energy;
+//	- the mixed rack steps the mixed path and its shots stay
+//	  finite and on the table.
+//
+//	Returns non zero on the first failure.
+//
+//	build: g++ -std=c++17 -O2 -ffp-contract=off -fno-math-errno -fno-trapping-math
+//	       tools/mixed_check.cpp game_cpp/shots.cpp game_cpp/pocketability.cpp
+//	       game_cpp/physics.cpp game_cpp/prediction.cpp -pthread
+//-------------------------------------------------------
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../game_cpp/physics_step.hpp"
+#include "../game_cpp/shots.hpp"
+
+
+namespace
+{
+	// relative, of the speeds of a single collision
+	constexpr float collisionTolerance = 1e-5f;
+	// share of shots of the standard rack the two paths must pocket the same balls on
+	constexpr float minSameOutcome = 0.99f;
+
+
+	float speedError( Vector2 a, Vector2 b, float scale )
+	{
+		return std::sqrt( ( a.x - b.x ) * ( a.x - b.x ) + ( a.y - b.y ) * ( a.y - b.y ) ) / scale;
+	}
+
+
+	bool sameBalls( PhysicTable const &a, PhysicTable const &b )
+	{
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		{
+			if ( a.inGame[ i ] != b.inGame[ i ] ||
+				a.balls[ i ].getPosition().x != b.balls[ i ].getPosition().x || a.balls[ i ].getPosition().y != b.balls[ i ].getPosition().y ||
+				a.balls[ i ].getSpeed().x != b.balls[ i ].getSpeed().x || a.balls[ i ].getSpeed().y != b.balls[ i ].getSpeed().y )
+				return false;
+		}
+		return true;
+	}
+
+
+	bool checkCollisions( Random::Stream &stream, int index )
+	{
+		Vector2 const offset = normalizedVector( Vector2( stream.uniform( -1.f, 1.f ), stream.uniform( -1.f, 1.f ) ) );
+		Vector2 const speed1( stream.uniform( -1.f, 1.f ), stream.uniform( -1.f, 1.f ) );
+		Vector2 const speed2( stream.uniform( -1.f, 1.f ), stream.uniform( -1.f, 1.f ) );
+
+		// equal balls, both kinds
+		BillBall uniform1( Vector2( 0.f, 0.f ) ), uniform2( Vector2( 2.f * Params::Ball::radius * offset.x, 2.f * Params::Ball::radius * offset.y ) );
+		uniform1.setSpeed( speed1 );
+		uniform2.setSpeed( speed2 );
+		BillBall mixed1 = uniform1, mixed2 = uniform2;
+		PhysicEvents::collide< PhysicEvents::UniformBalls >( &uniform1, &uniform2 );
+		PhysicEvents::collide< PhysicEvents::MixedBalls >( &mixed1, &mixed2 );
+
+		float const scale = std::max( std::sqrt( speed1.x * speed1.x + speed1.y * speed1.y ) + std::sqrt( speed2.x * speed2.x + speed2.y * speed2.y ), 1e-3f );
+		if ( speedError( uniform1.getSpeed(), mixed1.getSpeed(), scale ) > collisionTolerance ||
+			speedError( uniform2.getSpeed(), mixed2.getSpeed(), scale ) > collisionTolerance )
+		{
+			std::printf( "collision %d: the mixed collision of equal balls differs from the uniform one\n", index );
+			return false;
+		}
+
+		// unequal balls
+		float const mass1 = stream.uniform( 0.3f, 3.f ), mass2 = stream.uniform( 0.3f, 3.f );
+		BillBall heavy1( Vector2( 0.f, 0.f ) ), heavy2( offset );
+		heavy1.setMass( mass1 );
+		heavy2.setMass( mass2 );
+		heavy1.setSpeed( speed1 );
+		heavy2.setSpeed( speed2 );
+		PhysicEvents::collide< PhysicEvents::MixedBalls >( &heavy1, &heavy2 );
+
+		auto energy = []( BillBall const &ball ) { return 0.5f * ball.getMass() * ( ball.getSpeed().x * ball.getSpeed().x + ball.getSpeed().y * ball.getSpeed().y ); };
+		Vector2 const momentumBefore( mass1 * speed1.x + mass2 * speed2.x, mass1 * speed1.y + mass2 * speed2.y );
+		Vector2 const momentumAfter( mass1 * heavy1.getSpeed().x + mass2 * heavy2.getSpeed().x, mass1 * heavy1.getSpeed().y + mass2 * heavy2.getSpeed().y );
+		float const energyBefore = 0.5f * mass1 * ( speed1.x * speed1.x + speed1.y * speed1.y ) + 0.5f * mass2 * ( speed2.x * speed2.x + speed2.y * speed2.y );
+		float const energyAfter = energy( heavy1 ) + energy( heavy2 );
+		if ( speedError( momentumBefore, momentumAfter, scale * ( mass1 + mass2 ) ) > collisionTolerance ||
+			std::abs( energyAfter - energyBefore ) > collisionTolerance * std::max( energyBefore, 1e-3f ) )
+		{
+			std::printf( "collision %d: momentum or energy not kept between masses %g and %g\n", index, mass1, mass2 );
+			return false;
+		}
+		return true;
+	}
+
+
+	// returns -1 on a failure, else whether both paths pocketed the same balls
+	int compareStandardRack( Shot const &shot, int index )
+	{
+		PhysicTable standard;
+		standard.reset();
+		standard.strike( shot );
+		PhysicTable mixed = standard;
+
+		int standardMask = 0, mixedMask = 0;
+		bool touched = false;
+		for ( int step = 0; step < Params::Env::maxShotSteps && !( standard.isResting() && mixed.isResting() ); step++ )
+		{
+			StepEvents const events = standard.stepWith< PhysicStep::Standard >();
+			standardMask |= events.pocketedMask;
+			mixedMask |= mixed.stepWith< PhysicStep::Mixed >().pocketedMask;
+
+			touched = touched || events.contactMask != 0;
+			if ( !touched && !sameBalls( standard, mixed ) )
+			{
+				std::printf( "shot %d: the mixed path left the standard one before any contact, step %d\n", index, step );
+				return -1;
+			}
+		}
+		return standardMask == mixedMask ? 1 : 0;
+	}
+
+
+	bool checkMixedRack( Shot const &shot, int index )
+	{
+		PhysicTable table;
+		table.reset( PhysicTable::Rack::mixed );
+		if ( table.isUniform() )
+		{
+			std::printf( "the mixed rack is uniform\n" );
+			return false;
+		}
+
+		Shots::Outcome const outcome = Shots::play( table, shot );
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		{
+			BillBall const &ball = outcome.table.balls[ i ];
+			if ( ball.getRadius() != Params::Ball::radius * Params::Table::mixedRadiusScales[ i ] )
+			{
+				std::printf( "shot %d: ball %d lost its radius\n", index, i );
+				return false;
+			}
+			if ( !outcome.table.inGame[ i ] )
+				continue;
+
+			Vector2 const position = ball.getPosition();
+			if ( !std::isfinite( position.x ) || !std::isfinite( position.y ) ||
+				std::abs( position.x ) > 0.5f * Params::Table::width || std::abs( position.y ) > 0.5f * Params::Table::height )
+			{
+				std::printf( "shot %d: ball %d rests off the table at %g %g\n", index, i, position.x, position.y );
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+
+int main( int argc, char* argv[] )
+{
+	int const shots = argc > 1 ? std::atoi( argv[ 1 ] ) : 2000;
+	if ( shots <= 0 )
+	{
+		std::printf( "usage: mixed_check [ shots ]\n" );
+		return 2;
+	}
+
+	int sameOutcome = 0;
+	for ( int s = 0; s < shots; s++ )
+	{
+		Random::Stream stream( uint32_t( s ), 0, Random::Purpose::noise );
+		if ( !checkCollisions( stream, s ) )
+			return 1;
+
+		Shot const shot = Shots::randomShot( stream );
+		int const same = compareStandardRack( shot, s );
+		if ( same < 0 || !checkMixedRack( shot, s ) )
+			return 1;
+		sameOutcome += same;
+	}
+
+	float const sameShare = float( sameOutcome ) / float( shots );
+	std::printf( "mixed path: %d collisions kept momentum and energy, same pocketed balls as the standard path on %.1f%% of %d shots\n",
+		shots, 100.f * sameShare, shots );
+	if ( sameShare < minSameOutcome )
+	{
+		std::printf( "under the %.1f%% floor\n", 100.f * minSameOutcome );
+		return 1;
+	}
+	return 0;
+}
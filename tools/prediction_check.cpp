@@ -0,0 +1,148 @@
+//-------------------------------------------------------
+//	Check of the closed form predictions against stepped
+//	simulation:
+//
+//	- Prediction::ballRest of a lone ball must give the step
+//	  count of the stepped run and its rest position;
+//	- no event may happen within Prediction::stepsWithoutEvents
+//	  steps, on racks and broken racks;
+//	- Shots::playAdaptive, which takes those stretches as one
+//	  step, is compared with Shots::play by pocketed mask and
+//	  step count, for the record, on the standard and the
+//	  mixed rack.
+//
+//	Returns non zero on the first failed prediction.
+//
+//	build: g++ -std=c++17 -O2 -ffp-contract=off -fno-math-errno -fno-trapping-math
+//	       tools/prediction_check.cpp game_cpp/shots.cpp game_cpp/pocketability.cpp
+//	       game_cpp/physics.cpp game_cpp/prediction.cpp -pthread
+//-------------------------------------------------------
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../game_cpp/prediction.hpp"
+#include "../game_cpp/shots.hpp"
+
+
+namespace
+{
+	// the closed form sums in double, the step in float
+	constexpr float restTolerance = 1e-4f;
+
+
+	bool checkRest( Random::Stream &stream, int index )
+	{
+		PhysicTable table;
+		table.reset();
+		for ( int i = 1; i < PhysicTable::numBalls; i++ )
+			table.inGame[ i ] = false;
+		table.balls[ 0 ].setPosition( Vector2( 0.f, 0.f ) );
+
+		// slow enough to rest before any cushion
+		Shot shot = Shots::randomShot( stream );
+		shot.power *= 0.12f;
+		table.strike( shot );
+
+		Prediction::Rest const rest = Prediction::ballRest( table.balls[ 0 ] );
+		int steps = 0;
+		while ( !table.isResting() )
+		{
+			table.step();
+			steps++;
+		}
+
+		if ( steps != rest.steps || distance( table.balls[ 0 ].getPosition(), rest.position ) > restTolerance )
+		{
+			std::printf( "ball %d: rests after %d steps, predicted %d, %g off the predicted position\n",
+				index, steps, rest.steps, double( distance( table.balls[ 0 ].getPosition(), rest.position ) ) );
+			return false;
+		}
+		return true;
+	}
+
+
+	bool checkEventFree( PhysicTable table, Shot const &shot, int index, long &freeSteps, long &totalSteps )
+	{
+		table.strike( shot );
+		for ( int step = 0; step < Params::Env::maxShotSteps && !table.isResting(); )
+		{
+			int const free = Prediction::stepsWithoutEvents( table );
+			for ( int k = 0; k < free && !table.isResting(); k++, step++ )
+			{
+				if ( table.stepEvents().kinds() )
+				{
+					std::printf( "shot %d: event %d steps into a stretch of %d predicted free\n", index, k, free );
+					return false;
+				}
+				freeSteps++;
+				totalSteps++;
+			}
+			if ( !table.isResting() )
+			{
+				table.stepEvents();
+				step++;
+				totalSteps++;
+			}
+		}
+		return true;
+	}
+}
+
+
+int main( int argc, char* argv[] )
+{
+	int const shots = argc > 1 ? std::atoi( argv[ 1 ] ) : 2000;
+	if ( shots <= 0 )
+	{
+		std::printf( "usage: prediction_check [ shots ]\n" );
+		return 2;
+	}
+
+	long freeSteps = 0, totalSteps = 0, baseSteps = 0, adaptiveSteps = 0, mixedBaseSteps = 0, mixedAdaptiveSteps = 0;
+	int samePocketed = 0, mixedSamePocketed = 0;
+	for ( int s = 0; s < shots; s++ )
+	{
+		Random::Stream stream( uint32_t( s ), 0, Random::Purpose::noise );
+		if ( !checkRest( stream, s ) )
+			return 1;
+
+		PhysicTable table;
+		table.reset();
+		Shots::jitterRack( table, stream );
+		// every other shot on a broken rack
+		if ( s % 2 )
+		{
+			Shots::Outcome const broken = Shots::play( table, Shots::randomShot( stream ) );
+			if ( broken.table.inGame[ 0 ] )
+				table = broken.table;
+		}
+
+		Shot const shot = Shots::randomShot( stream );
+		if ( !checkEventFree( table, shot, s, freeSteps, totalSteps ) )
+			return 1;
+
+		Shots::Outcome const base = Shots::play( table, shot );
+		Shots::Outcome const adaptive = Shots::playAdaptive( table, shot );
+		baseSteps += base.steps;
+		adaptiveSteps += adaptive.steps;
+		samePocketed += base.pocketedMask == adaptive.pocketedMask ? 1 : 0;
+
+		PhysicTable mixed;
+		mixed.reset( PhysicTable::Rack::mixed );
+		Shots::jitterRack( mixed, stream );
+		Shots::Outcome const mixedBase = Shots::play( mixed, shot );
+		Shots::Outcome const mixedAdaptive = Shots::playAdaptive( mixed, shot );
+		mixedBaseSteps += mixedBase.steps;
+		mixedAdaptiveSteps += mixedAdaptive.steps;
+		mixedSamePocketed += mixedBase.pocketedMask == mixedAdaptive.pocketedMask ? 1 : 0;
+	}
+
+	std::printf( "predictions hold: %d lone balls rest as predicted, %ld of %ld steps predicted event free\n", shots, freeSteps, totalSteps );
+	std::printf( "adaptive steps: %ld against %ld base steps, same pocketed mask on %.1f%% of the shots\n",
+		adaptiveSteps, baseSteps, 100. * samePocketed / shots );
+	std::printf( "on the mixed rack: %ld against %ld base steps, same pocketed mask on %.1f%% of the shots\n",
+		mixedAdaptiveSteps, mixedBaseSteps, 100. * mixedSamePocketed / shots );
+	return 0;
+}
@@ -0,0 +1,192 @@
+//-------------------------------------------------------
+//	Check of the seekable replays: a few shots on the
+//	standard rack, then a reset to the mixed rack and a few
+//	more, racked again after a scratch, recorded with Replay::Writer while every frame's
+//	table is kept. Replay::Reader must seek to random frames
+//	and give those tables bit for bit. Copies of the file cut
+//	at random offsets must either fail to open or reopen as
+//	incomplete, seek the frames they still hold to the same
+//	tables and fail past them.
+//
+//	Returns non zero on the first failure.
+//
+//	build: g++ -std=c++17 -O2 -ffp-contract=off -fno-math-errno -fno-trapping-math
+//	       tools/replay_check.cpp game_cpp/replay.cpp game_cpp/shots.cpp
+//	       game_cpp/pocketability.cpp game_cpp/physics.cpp game_cpp/prediction.cpp -pthread
+//-------------------------------------------------------
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "../game_cpp/replay.hpp"
+#include "../game_cpp/shots.hpp"
+
+
+namespace
+{
+	constexpr int shotsPerRack = 6;
+	constexpr int seeks = 200;
+	constexpr int cuts = 40;
+
+
+	bool sameBits( float a, float b )
+	{
+		uint32_t x, y;
+		std::memcpy( &x, &a, sizeof( x ) );
+		std::memcpy( &y, &b, sizeof( y ) );
+		return x == y;
+	}
+
+
+	bool sameTable( PhysicTable const &a, PhysicTable const &b )
+	{
+		for ( int i = 0; i < PhysicTable::numBalls; i++ )
+		{
+			BillBall const &ballA = a.balls[ i ], &ballB = b.balls[ i ];
+			if ( a.inGame[ i ] != b.inGame[ i ] ||
+				!sameBits( ballA.getPosition().x, ballB.getPosition().x ) || !sameBits( ballA.getPosition().y, ballB.getPosition().y ) ||
+				!sameBits( ballA.getSpeed().x, ballB.getSpeed().x ) || !sameBits( ballA.getSpeed().y, ballB.getSpeed().y ) ||
+				!sameBits( ballA.getRadius(), ballB.getRadius() ) || !sameBits( ballA.getMass(), ballB.getMass() ) )
+				return false;
+		}
+		return true;
+	}
+
+
+	// the table of every frame, as the reader defines it: after the steps and the records stamped with it
+	std::vector< PhysicTable > record( char const* path, Random::Stream &stream )
+	{
+		Replay::Writer writer;
+		std::vector< PhysicTable > frames;
+		if ( !writer.open( path ) )
+			return frames;
+
+		PhysicTable table;
+		auto rerack = [ & ]( PhysicTable::Rack rack )
+		{
+			table.reset( rack );
+			writer.reset( table );
+			if ( frames.empty() )
+				frames.push_back( table );
+			frames.back() = table;
+		};
+
+		for ( PhysicTable::Rack rack : { PhysicTable::Rack::standard, PhysicTable::Rack::mixed } )
+		{
+			rerack( rack );
+			for ( int s = 0; s < shotsPerRack; s++ )
+			{
+				// a scratch racks again, a reset in the middle of the recording
+				if ( !table.inGame[ 0 ] )
+					rerack( rack );
+
+				Shot const shot = Shots::randomShot( stream );
+				if ( table.strike( shot ) )
+				{
+					writer.strike( shot );
+					frames.back() = table;
+				}
+
+				for ( int step = 0; step < Params::Env::maxShotSteps && !table.isResting(); step++ )
+				{
+					table.step();
+					writer.step( table );
+					frames.push_back( table );
+				}
+			}
+		}
+		writer.close();
+		return frames;
+	}
+
+
+	bool checkSeeks( Replay::Reader &reader, std::vector< PhysicTable > const &frames, uint32_t lastFrame, Random::Stream &stream, char const* name )
+	{
+		PhysicTable table;
+		for ( int s = 0; s < seeks; s++ )
+		{
+			uint32_t const frame = std::min( uint32_t( stream.uniform() * float( lastFrame + 1 ) ), lastFrame );
+			if ( !reader.seek( frame, table ) || !sameTable( table, frames[ frame ] ) )
+			{
+				std::printf( "%s: frame %u doesn't seek to the recorded table\n", name, frame );
+				return false;
+			}
+		}
+		if ( reader.seek( lastFrame + 1, table ) )
+		{
+			std::printf( "%s: seeks past its last frame %u\n", name, lastFrame );
+			return false;
+		}
+		return true;
+	}
+}
+
+
+int main( int argc, char* argv[] )
+{
+	std::string const path = argc > 1 ? argv[ 1 ] : "replay_check.bin";
+	std::string const cutPath = path + ".cut";
+
+	Random::Stream stream( 0, 0, Random::Purpose::noise );
+	std::vector< PhysicTable > const frames = record( path.c_str(), stream );
+	if ( frames.empty() )
+	{
+		std::printf( "can't write %s\n", path.c_str() );
+		return 2;
+	}
+
+	Replay::Reader reader;
+	uint32_t const lastFrame = uint32_t( frames.size() - 1 );
+	if ( !reader.open( path.c_str() ) || !reader.isComplete() || reader.frameCount() != lastFrame )
+	{
+		std::printf( "the whole file doesn't open with its index and %u frames\n", lastFrame );
+		return 1;
+	}
+	if ( !checkSeeks( reader, frames, lastFrame, stream, "whole file" ) )
+		return 1;
+
+	std::vector< char > bytes;
+	{
+		std::ifstream file( path, std::ios::binary );
+		bytes.assign( std::istreambuf_iterator< char >( file ), std::istreambuf_iterator< char >() );
+	}
+
+	int rejected = 0, reopened = 0;
+	for ( int c = 0; c < cuts; c++ )
+	{
+		size_t const size = std::min( size_t( stream.uniform() * float( bytes.size() ) ), bytes.size() - 1 );
+		{
+			std::ofstream file( cutPath, std::ios::binary | std::ios::trunc );
+			file.write( bytes.data(), std::streamsize( size ) );
+		}
+
+		Replay::Reader cut;
+		if ( !cut.open( cutPath.c_str() ) )
+		{
+			rejected++;
+			continue;
+		}
+		reopened++;
+
+		std::string const name = "cut at " + std::to_string( size );
+		if ( cut.isComplete() || cut.frameCount() > lastFrame )
+		{
+			std::printf( "%s: opens as a complete file of %u frames\n", name.c_str(), cut.frameCount() );
+			return 1;
+		}
+		if ( !checkSeeks( cut, frames, cut.frameCount(), stream, name.c_str() ) )
+			return 1;
+	}
+	std::remove( cutPath.c_str() );
+
+	std::printf( "replay seeks match the recording: %u frames, %zu keyframes, %d seeks\n", lastFrame, reader.keyframes().size(), seeks );
+	std::printf( "cut files: %d fail to open, %d reopen incomplete and seek what they hold\n", rejected, reopened );
+	return 0;
+}
@@ -0,0 +1,138 @@
+//-------------------------------------------------------
+//	Agreement of the coarse screening tier with the full
+//	simulation: random shots on broken racks, standard and
+//	mixed, are played in both tiers and compared by pocketed
+//	mask, then screened the way the planner's root is, audits
+//	included. Prints the rates and the time of each tier.
+//
+//	The verified shots are the ones the coarse tier ranks as
+//	pots, the shots where it errs most: a cut a fraction of a
+//	degree off decides them. They agree far less often than
+//	the whole pool, which is fine as long as the full tier
+//	re-ranks them and they stay better shots than the pool.
+//	So it returns non zero if, on either rack, the agreement
+//	over all shots or over the verified shots drops under its
+//	floor, or the verified shots' mean full reward doesn't
+//	beat the pool's.
+//
+//	build: g++ -std=c++17 -O2 -ffp-contract=off -fno-math-errno -fno-trapping-math
+//	       tools/screening_check.cpp game_cpp/screening.cpp game_cpp/shots.cpp
+//	       game_cpp/pocketability.cpp game_cpp/physics.cpp game_cpp/prediction.cpp -pthread
+//-------------------------------------------------------
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../game_cpp/screening.hpp"
+
+
+namespace
+{
+	using Clock = std::chrono::steady_clock;
+
+
+	struct Floors
+	{
+		float all;
+		float verified;
+	};
+
+
+	bool checkRack( PhysicTable::Rack rack, int tables, Floors floors )
+	{
+		Screening::Report report;
+		int shots = 0, agreed = 0, pottingAgreed = 0, potting = 0;
+		double coarseSeconds = 0., fullSeconds = 0.;
+		double poolReward = 0., verifiedReward = 0.;
+		for ( int t = 0; t < tables; t++ )
+		{
+			Random::Stream stream( uint32_t( t ), 0, Random::Purpose::noise );
+			PhysicTable table;
+			table.reset( rack );
+			Shots::jitterRack( table, stream );
+			// the first table keeps the rack, the planner screens the break too
+			Shots::Outcome const broken = Shots::play( table, Shots::randomShot( stream ) );
+			if ( broken.table.inGame[ 0 ] && t > 0 )
+				table = broken.table;
+
+			std::vector< Shot > pool( Params::Screening::rootPool );
+			for ( Shot &shot : pool )
+				shot = Shots::randomShot( stream );
+
+			std::vector< int > coarseMasks( pool.size() ), fullMasks( pool.size() );
+			Clock::time_point const start = Clock::now();
+			for ( size_t i = 0; i < pool.size(); i++ )
+				coarseMasks[ i ] = Screening::coarsePlay( table, pool[ i ] ).pocketedMask;
+			Clock::time_point const middle = Clock::now();
+			for ( size_t i = 0; i < pool.size(); i++ )
+				fullMasks[ i ] = Shots::play( table, pool[ i ] ).pocketedMask;
+			Clock::time_point const end = Clock::now();
+			coarseSeconds += std::chrono::duration< double >( middle - start ).count();
+			fullSeconds += std::chrono::duration< double >( end - middle ).count();
+
+			for ( size_t i = 0; i < pool.size(); i++ )
+			{
+				shots++;
+				poolReward += Shots::reward( fullMasks[ i ] );
+				agreed += coarseMasks[ i ] == fullMasks[ i ] ? 1 : 0;
+				if ( fullMasks[ i ] & ~1 )
+				{
+					potting++;
+					pottingAgreed += coarseMasks[ i ] == fullMasks[ i ] ? 1 : 0;
+				}
+			}
+
+			for ( Screening::Result const &verified : Screening::screen( table, pool, report ) )
+				verifiedReward += Shots::reward( verified.outcome.pocketedMask );
+		}
+
+		float const agreement = float( agreed ) / float( shots );
+		double const poolMean = poolReward / shots, verifiedMean = report.verified ? verifiedReward / report.verified : 0.;
+		std::printf( "%s rack\n", rack == PhysicTable::Rack::standard ? "standard" : "mixed" );
+		std::printf( "  all shots: %d, same pocketed mask %.3f, on potting shots %.3f\n",
+			shots, agreement, potting ? float( pottingAgreed ) / float( potting ) : 1.f );
+		std::printf( "  screened: %d, verified %d agreeing %.3f, audited %d agreeing %.3f\n",
+			report.screened, report.verified, report.agreementRate(), report.audited, report.auditAgreementRate() );
+		std::printf( "  mean full reward: pool %.3f, verified %.3f\n", poolMean, verifiedMean );
+		std::printf( "  coarse %.3f s, full %.3f s\n", coarseSeconds, fullSeconds );
+
+		if ( agreement < floors.all )
+		{
+			std::printf( "agreement under the floor of %.3f\n", floors.all );
+			return false;
+		}
+		if ( report.agreementRate() < floors.verified )
+		{
+			std::printf( "verified agreement under the floor of %.3f\n", floors.verified );
+			return false;
+		}
+		if ( verifiedMean <= poolMean )
+		{
+			std::printf( "the verified shots are no better than the pool\n" );
+			return false;
+		}
+		return true;
+	}
+}
+
+
+int main( int argc, char* argv[] )
+{
+	int const tables = argc > 1 ? std::atoi( argv[ 1 ] ) : 40;
+	Floors floors;
+	floors.all = argc > 2 ? float( std::atof( argv[ 2 ] ) ) : 0.7f;
+	floors.verified = argc > 3 ? float( std::atof( argv[ 3 ] ) ) : 0.12f;
+	if ( tables <= 0 )
+	{
+		std::printf( "usage: screening_check [ tables [ agreement floor [ verified agreement floor ] ] ]\n" );
+		return 2;
+	}
+
+	for ( PhysicTable::Rack rack : { PhysicTable::Rack::standard, PhysicTable::Rack::mixed } )
+		if ( !checkRack( rack, tables, floors ) )
+			return 1;
+	return 0;
+}
@@ -0,0 +1,145 @@
+//-------------------------------------------------------
+//	Check of the speculative shot questions: on broken
+//	racks with random shots and ghost ball pots, the early
+//	exit answers of Shots::isBallPocketed, isScratch and
+//	firstContact must match a full run stepped to rest, on
+//	the standard and the mixed rack. Returns non zero on the
+//	first mismatch, or if too few ghost ball pots of a rack
+//	hit their target ball first.
+//
+//	build: g++ -std=c++17 -O2 -ffp-contract=off -fno-math-errno -fno-trapping-math
+//	       tools/shots_check.cpp game_cpp/shots.cpp game_cpp/pocketability.cpp
+//	       game_cpp/physics.cpp game_cpp/prediction.cpp -pthread
+//-------------------------------------------------------
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../game_cpp/shots.hpp"
+
+
+namespace
+{
+	// share of ghost ball pots that must hit their target first, per rack
+	constexpr float minOnTarget = 0.95f;
+
+
+	struct Run
+	{
+		int pocketedMask = 0;
+		int firstContact = -1;
+	};
+
+
+	// the reference: every step to rest, the first cue ball contact noted on the way
+	Run runToRest( PhysicTable const &table, Shot const &shot )
+	{
+		PhysicTable current = table;
+		current.strike( shot );
+
+		Run run;
+		bool decided = false;
+		for ( int step = 0; step < Params::Env::maxShotSteps && !current.isResting(); step++ )
+		{
+			StepEvents const events = current.stepEvents();
+			run.pocketedMask |= events.pocketedMask;
+
+			// contacts of one step come before a pocketed cue ball, the lowest ball first
+			for ( int i = 1; i < PhysicTable::numBalls && !decided; i++ )
+			{
+				if ( events.contactPairs & ( uint64_t( 1 ) << i ) )
+				{
+					run.firstContact = i;
+					decided = true;
+				}
+			}
+			decided = decided || !current.inGame[ 0 ];
+		}
+		return run;
+	}
+
+
+	bool check( PhysicTable const &table, Shot const &shot, int index )
+	{
+		Run const run = runToRest( table, shot );
+
+		int const contact = Shots::firstContact( table, shot );
+		if ( contact != run.firstContact )
+		{
+			std::printf( "shot %d: firstContact %d, full run %d\n", index, contact, run.firstContact );
+			return false;
+		}
+		if ( Shots::isScratch( table, shot ) != Shots::isScratch( run.pocketedMask ) )
+		{
+			std::printf( "shot %d: isScratch disagrees with the full run\n", index );
+			return false;
+		}
+		for ( int ball = 0; ball < PhysicTable::numBalls; ball++ )
+		{
+			if ( Shots::isBallPocketed( table, shot, ball ) != ( ( run.pocketedMask & ( 1 << ball ) ) != 0 ) )
+			{
+				std::printf( "shot %d: isBallPocketed( %d ) disagrees with the full run\n", index, ball );
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+
+int main( int argc, char* argv[] )
+{
+	int const tables = argc > 1 ? std::atoi( argv[ 1 ] ) : 1000;
+	if ( tables <= 0 )
+	{
+		std::printf( "usage: shots_check [ tables ]\n" );
+		return 2;
+	}
+
+	int shots = 0, scratches = 0, contacts = 0;
+	for ( PhysicTable::Rack rack : { PhysicTable::Rack::standard, PhysicTable::Rack::mixed } )
+	{
+		int pots = 0, potsOnTarget = 0;
+		for ( int t = 0; t < tables; t++ )
+		{
+			Random::Stream stream( uint32_t( t ), 0, Random::Purpose::noise );
+			PhysicTable table;
+			table.reset( rack );
+			Shots::jitterRack( table, stream );
+			// a break first, the rack itself has no clear pots
+			Shots::Outcome const broken = Shots::play( table, Shots::randomShot( stream ) );
+			if ( broken.table.inGame[ 0 ] )
+				table = broken.table;
+
+			std::vector< Shot > candidates = { Shots::randomShot( stream ) };
+			for ( Shots::Candidate const &candidate : Shots::ghostBallCandidates( table ) )
+			{
+				candidates.push_back( candidate.shot );
+				pots++;
+				potsOnTarget += Shots::firstContact( table, candidate.shot ) == candidate.ball ? 1 : 0;
+			}
+
+			for ( Shot const &shot : candidates )
+			{
+				if ( !check( table, shot, shots ) )
+					return 1;
+				scratches += Shots::isScratch( table, shot ) ? 1 : 0;
+				contacts += Shots::firstContact( table, shot ) >= 0 ? 1 : 0;
+				shots++;
+			}
+		}
+
+		char const* const name = rack == PhysicTable::Rack::standard ? "standard" : "mixed";
+		std::printf( "ghost ball pots hitting their target first, %s rack: %d of %d\n", name, potsOnTarget, pots );
+		if ( pots > 0 && float( potsOnTarget ) < minOnTarget * float( pots ) )
+		{
+			std::printf( "under the %.0f%% floor\n", 100.f * minOnTarget );
+			return 1;
+		}
+	}
+
+	std::printf( "shot questions match the full runs: %d shots, %d scratches, %d with a contact\n", shots, scratches, contacts );
+	return 0;
+}
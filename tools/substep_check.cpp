@@ -0,0 +1,160 @@
+//-------------------------------------------------------
+//	Check of the per ball substeps of PhysicTable::stepEvents:
+//
+//	- a fast cue ball grazing a lone target ball, on the
+//	  standard and the mixed rack, must touch it within the
+//	  first steps with substeps; the chord it crosses is
+//	  longer than a substep and shorter than a base step,
+//	  so the base step must jump over a share of them;
+//	- neither path may touch a target the cue ball passes.
+//
+//	For the record it compares the pocketed balls of opening
+//	shots played in base steps, with substeps and in eighth
+//	and sixteenth steps: a break tells any two step sizes
+//	apart on about a fifth of the shots, substeps included.
+//
+//	Returns non zero on the first failure.
+//
+//	build: g++ -std=c++17 -O2 -ffp-contract=off -fno-math-errno -fno-trapping-math
+//	       tools/substep_check.cpp game_cpp/shots.cpp game_cpp/pocketability.cpp
+//	       game_cpp/physics.cpp game_cpp/prediction.cpp -pthread
+//-------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../game_cpp/physics_step.hpp"
+#include "../game_cpp/shots.hpp"
+
+
+namespace
+{
+	// steps the cue ball takes to pass the target
+	constexpr int grazeSteps = 8;
+	// share of grazes the base step must miss, it catches about a chord over a step of them
+	constexpr float minBaseMisses = 0.2f;
+	// the chord is kept this far over a substep, and the passes this far off a contact
+	constexpr float margin = 1.1f;
+
+
+	// the cue ball from the left at full power along y = offset, a lone target at the centre
+	PhysicTable grazeTable( PhysicTable::Rack rack, int target, float offset, float phase )
+	{
+		PhysicTable table;
+		table.reset( rack );
+		for ( int i = 1; i < PhysicTable::numBalls; i++ )
+			table.inGame[ i ] = i == target;
+		table.balls[ 0 ].setPosition( Vector2( -3.f - phase, offset ) );
+		table.balls[ target ].setPosition( Vector2( 0.f, 0.f ) );
+
+		Shot shot;
+		shot.direction = Vector2( 1.f, 0.f );
+		shot.power = 1.f;
+		table.strike( shot );
+		return table;
+	}
+
+
+	bool touches( PhysicTable table, bool substeps )
+	{
+		for ( int step = 0; step < grazeSteps; step++ )
+			if ( table.stepEvents( 1.f, substeps ).contactMask & 1 )
+				return true;
+		return false;
+	}
+
+
+	bool checkGrazes( PhysicTable::Rack rack, int shots )
+	{
+		char const* const name = rack == PhysicTable::Rack::standard ? "standard" : "mixed";
+		int baseMisses = 0;
+		for ( int s = 0; s < shots; s++ )
+		{
+			Random::Stream stream( uint32_t( s ), 0, Random::Purpose::noise );
+			int const target = 1 + int( stream.uniform() * float( PhysicTable::numBalls - 1 ) ) % ( PhysicTable::numBalls - 1 );
+			float const phase = stream.uniform();
+
+			PhysicTable const probe = grazeTable( rack, target, 0.f, phase );
+			BillBall const &cue = probe.balls[ 0 ];
+			float const speed = std::sqrt( cue.getSpeed().x * cue.getSpeed().x + cue.getSpeed().y * cue.getSpeed().y );
+			float const substep = speed / float( PhysicStep::substepsFor( cue, cue.getRadius(), 1.f ) );
+			float const contact = cue.getRadius() + probe.balls[ target ].getRadius();
+
+			// a chord of 2 * sqrt( contact^2 - offset^2 ) between a substep and a base step
+			float const nearest = std::sqrt( contact * contact - 0.25f * speed * speed );
+			float const farthest = std::sqrt( contact * contact - 0.25f * margin * margin * substep * substep );
+			float const offset = nearest + stream.uniform() * ( farthest - nearest );
+
+			PhysicTable const graze = grazeTable( rack, target, offset, phase );
+			if ( !touches( graze, true ) )
+			{
+				std::printf( "%s rack, shot %d: substeps miss a graze at %g of a %g contact\n", name, s, offset, contact );
+				return false;
+			}
+			baseMisses += touches( graze, false ) ? 0 : 1;
+
+			PhysicTable const pass = grazeTable( rack, target, margin * contact, phase );
+			if ( touches( pass, true ) || touches( pass, false ) )
+			{
+				std::printf( "%s rack, shot %d: a pass at %g touches a %g contact\n", name, s, margin * contact, contact );
+				return false;
+			}
+		}
+
+		std::printf( "%s rack: substeps touch all %d grazes, the base step misses %d\n", name, shots, baseMisses );
+		if ( float( baseMisses ) < minBaseMisses * float( shots ) )
+		{
+			std::printf( "the base step misses under %.0f%%, the grazes don't test the substeps\n", 100.f * minBaseMisses );
+			return false;
+		}
+		return true;
+	}
+
+
+	int playInSteps( PhysicTable const &table, Shot const &shot, float stepSize, bool substeps )
+	{
+		PhysicTable current = table;
+		current.strike( shot );
+		int pocketedMask = 0;
+		for ( float elapsed = 0.f; elapsed < float( Params::Env::maxShotSteps ) && !current.isResting(); elapsed += stepSize )
+			pocketedMask |= current.stepEvents( stepSize, substeps ).pocketedMask;
+		return pocketedMask;
+	}
+}
+
+
+int main( int argc, char* argv[] )
+{
+	int const shots = argc > 1 ? std::atoi( argv[ 1 ] ) : 1000;
+	if ( shots <= 0 )
+	{
+		std::printf( "usage: substep_check [ shots ]\n" );
+		return 2;
+	}
+
+	if ( !checkGrazes( PhysicTable::Rack::standard, shots ) || !checkGrazes( PhysicTable::Rack::mixed, shots ) )
+		return 1;
+
+	int const breaks = std::max( shots / 4, 1 );
+	int substepped = 0, eighth = 0, eighthSixteenth = 0;
+	for ( int s = 0; s < breaks; s++ )
+	{
+		Random::Stream stream( uint32_t( s ), 0, Random::Purpose::noise );
+		PhysicTable table;
+		table.reset();
+		Shots::jitterRack( table, stream );
+		Shot const shot = Shots::randomShot( stream );
+
+		int const base = playInSteps( table, shot, 1.f, false );
+		int const eighths = playInSteps( table, shot, 0.125f, false );
+		substepped += playInSteps( table, shot, 1.f, true ) == base ? 1 : 0;
+		eighth += eighths == base ? 1 : 0;
+		eighthSixteenth += playInSteps( table, shot, 0.0625f, false ) == eighths ? 1 : 0;
+	}
+	std::printf( "same pocketed balls on %d opening shots: base and substeps %.1f%%, base and eighth steps %.1f%%, eighth and sixteenth steps %.1f%%\n",
+		breaks, 100. * substepped / breaks, 100. * eighth / breaks, 100. * eighthSixteenth / breaks );
+	return 0;
+}